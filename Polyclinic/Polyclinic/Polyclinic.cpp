@@ -2,35 +2,527 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <utility>     // std::exchange
 #include <fstream>
+#include <iterator>    // std::istreambuf_iterator — читання файлу в перевірках
+#include <array>
+#include <algorithm>
+#include <cstring>
+#include <charconv>    // std::from_chars — розбір віку без тимчасових рядків
+#include <string_view>
+#include <chrono>
+#include <cstdio>      // std::remove
+#include <new>         // std::align_val_t
+#include <thread>
+#include <exception>
+#include <cstdint>
+#include <unordered_map>
+#include <map>
+#include <limits>
+#include <variant>
+#include <type_traits>
+#include <memory_resource> // std::pmr — арена для пацієнтів і їхніх рядків
+#include <mutex>
+#include <shared_mutex>
+#include <filesystem>
 #include <stdexcept> // власні виключення наслідують від std::runtime_error
 
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define POLYCLINIC_X86 1
+#include <immintrin.h> // SSE2/AVX2 для пошуку роздільників
+#ifdef _MSC_VER
+#include <intrin.h>    // __cpuid, _xgetbv
+#endif
+#endif
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 // ===========================
 // Власні виключення (п.9)
 // ===========================
 struct FileSaveError : public std::runtime_error { using std::runtime_error::runtime_error; };
+struct FileLoadError : public std::runtime_error { using std::runtime_error::runtime_error; };
 struct EmptyClinicError : public std::runtime_error { using std::runtime_error::runtime_error; };
 struct PatientIndexError : public std::runtime_error { using std::runtime_error::runtime_error; };
 
+// ===========================
+// MappedFile: файл, відображений у пам'ять (лише читання)
+// POSIX: mmap + madvise(MADV_SEQUENTIAL); Windows: CreateFileMapping/MapViewOfFile
+// (на Windows послідовне читання підказує сама ОС, аналога madvise не потрібно)
+// ===========================
+class MappedFile {
+private:
+    const char* mapped = nullptr;
+    std::size_t length = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+
+public:
+    explicit MappedFile(const std::string& filepath) {
+#ifdef _WIN32
+        file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) throw FileLoadError("Не вдається відкрити файл: " + filepath);
+        LARGE_INTEGER size{};
+        if (!GetFileSizeEx(file, &size)) {
+            CloseHandle(file);
+            throw FileLoadError("Не вдається визначити розмір файлу: " + filepath);
+        }
+        length = static_cast<std::size_t>(size.QuadPart);
+        if (length == 0) return; // порожній файл відобразити неможливо — і не потрібно
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping) mapped = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!mapped) {
+            if (mapping) CloseHandle(mapping);
+            CloseHandle(file);
+            throw FileLoadError("Не вдається відобразити файл у пам'ять: " + filepath);
+        }
+#else
+        const int fd = ::open(filepath.c_str(), O_RDONLY);
+        if (fd < 0) throw FileLoadError("Не вдається відкрити файл: " + filepath);
+        struct stat st {};
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw FileLoadError("Не вдається визначити розмір файлу: " + filepath);
+        }
+        length = static_cast<std::size_t>(st.st_size);
+        if (length > 0) {
+            void* p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                throw FileLoadError("Не вдається відобразити файл у пам'ять: " + filepath);
+            }
+            ::madvise(p, length, MADV_SEQUENTIAL); // лише підказка ядру: помилку ігноруємо
+            mapped = static_cast<const char*>(p);
+        }
+        ::close(fd); // відображення лишається дійсним і без дескриптора
+#endif
+    }
+
+    ~MappedFile() {
+#ifdef _WIN32
+        if (mapped) UnmapViewOfFile(mapped);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+        if (mapped) ::munmap(const_cast<char*>(mapped), length);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* begin() const { return mapped; }
+    const char* end() const { return mapped + length; }
+    std::size_t size() const { return length; }
+};
+
+// Тег підтипу пацієнта (для бінарних форматів, де немає текстового токена TYPE)
+enum class PatientType : std::uint8_t { Patient = 0, Child = 1, Elder = 2 };
+
+// ===========================
+// AppendFile: файл лише для дописування з явним fsync (для журналу змін)
+// POSIX: open/write/fsync/ftruncate; Windows: CreateFile/WriteFile/FlushFileBuffers/SetEndOfFile
+// ===========================
+class AppendFile {
+private:
+    std::string path;
+#ifdef _WIN32
+    HANDLE handle = INVALID_HANDLE_VALUE;
+#else
+    int fd = -1;
+#endif
+
+public:
+    explicit AppendFile(std::string filepath) : path(std::move(filepath)) {
+#ifdef _WIN32
+        handle = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+            OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (handle == INVALID_HANDLE_VALUE) throw FileSaveError("Не вдається відкрити файл: " + path);
+#else
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd < 0) throw FileSaveError("Не вдається відкрити файл: " + path);
+#endif
+    }
+
+    ~AppendFile() {
+#ifdef _WIN32
+        if (handle != INVALID_HANDLE_VALUE) CloseHandle(handle);
+#else
+        if (fd >= 0) ::close(fd);
+#endif
+    }
+
+    AppendFile(const AppendFile&) = delete;
+    AppendFile& operator=(const AppendFile&) = delete;
+
+    void write(const char* data, std::size_t size) {
+#ifdef _WIN32
+        LARGE_INTEGER zero{};
+        SetFilePointerEx(handle, zero, nullptr, FILE_END);
+        while (size > 0) {
+            DWORD written = 0;
+            const DWORD chunk = static_cast<DWORD>(size < (1u << 30) ? size : (1u << 30));
+            if (!WriteFile(handle, data, chunk, &written, nullptr)) throw FileSaveError("Помилка запису файлу: " + path);
+            data += written;
+            size -= written;
+        }
+#else
+        while (size > 0) {
+            const ssize_t written = ::write(fd, data, size);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                throw FileSaveError("Помилка запису файлу: " + path);
+            }
+            data += written;
+            size -= static_cast<std::size_t>(written);
+        }
+#endif
+    }
+
+    // Дані (і розмір файлу) гарантовано на диску після повернення
+    void sync() {
+#ifdef _WIN32
+        if (!FlushFileBuffers(handle)) throw FileSaveError("Помилка fsync: " + path);
+#else
+        if (::fsync(fd) != 0) throw FileSaveError("Помилка fsync: " + path);
+#endif
+    }
+
+    void truncate(std::uint64_t size) {
+#ifdef _WIN32
+        LARGE_INTEGER pos{};
+        pos.QuadPart = static_cast<LONGLONG>(size);
+        if (!SetFilePointerEx(handle, pos, nullptr, FILE_BEGIN) || !SetEndOfFile(handle))
+            throw FileSaveError("Не вдається обрізати файл: " + path);
+#else
+        if (::ftruncate(fd, static_cast<off_t>(size)) != 0) throw FileSaveError("Не вдається обрізати файл: " + path);
+#endif
+    }
+};
+
+inline double elapsedMs(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+// fsync каталогу: після rename запис каталогу (нове ім'я файлу) теж має бути на диску.
+// На Windows (NTFS журналює метадані) окремого кроку не потрібно
+inline void syncDirectory(const std::filesystem::path& dir) {
+#ifndef _WIN32
+    const int fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY);
+    if (fd < 0) throw FileSaveError("Не вдається відкрити каталог: " + dir.string());
+    const int rc = ::fsync(fd);
+    ::close(fd);
+    if (rc != 0) throw FileSaveError("Помилка fsync каталогу: " + dir.string());
+#else
+    (void)dir;
+#endif
+}
+
+// Рівень довговічності атомарного збереження
+enum class Durability {
+    None,  // без fsync (масовий імпорт): файл не буває напівзаписаним, але після збою ОС
+           // може лишитися попередня версія
+    Fsync  // fsync файлу перед rename і fsync каталогу після — переживає збій живлення
+};
+
+// Статистика збереження: час запису і час fsync окремо
+struct SaveStats {
+    std::uint64_t bytes = 0;
+    double writeMs = 0;
+    double fsyncMs = 0;
+};
+
+// ===========================
+// AtomicFileWriter: запис у тимчасовий файл поруч із цільовим, fsync, rename поверх
+// цільового, fsync каталогу. Збій посеред запису лишає попередній файл цілим.
+// Дані йдуть у файл вирівняними блоками по 1 МіБ із власного буфера.
+// Без commit() (виключення) тимчасовий файл видаляється
+// ===========================
+class AtomicFileWriter {
+private:
+    static constexpr std::size_t kBlockSize = 1 << 20;
+    static constexpr std::size_t kBlockAlign = 4096;
+
+    struct AlignedDelete {
+        void operator()(char* p) const { ::operator delete(p, std::align_val_t{ kBlockAlign }); }
+    };
+
+    std::string target;
+    std::string temp;
+    Durability durability;
+    std::unique_ptr<AppendFile> file;
+    std::unique_ptr<char, AlignedDelete> block;
+    std::size_t used = 0;
+    SaveStats stats;
+    std::chrono::steady_clock::time_point started;
+
+    void flushBlock() {
+        file->write(block.get(), used);
+        stats.bytes += used;
+        used = 0;
+    }
+
+public:
+    AtomicFileWriter(std::string filepath, Durability durability)
+        : target(std::move(filepath)), temp(target + ".tmp"), durability(durability),
+        block(static_cast<char*>(::operator new(kBlockSize, std::align_val_t{ kBlockAlign }))),
+        started(std::chrono::steady_clock::now()) {
+        file = std::make_unique<AppendFile>(temp);
+        file->truncate(0); // залишок попередньої невдалої спроби
+    }
+
+    ~AtomicFileWriter() {
+        if (!file) return;
+        file.reset();
+        std::error_code ec;
+        std::filesystem::remove(temp, ec);
+    }
+
+    AtomicFileWriter(const AtomicFileWriter&) = delete;
+    AtomicFileWriter& operator=(const AtomicFileWriter&) = delete;
+
+    void write(const char* data, std::size_t size) {
+        while (size > 0) {
+            const std::size_t chunk = std::min(size, kBlockSize - used);
+            std::memcpy(block.get() + used, data, chunk);
+            used += chunk;
+            data += chunk;
+            size -= chunk;
+            if (used == kBlockSize) flushBlock();
+        }
+    }
+
+    SaveStats commit() {
+        flushBlock();
+        if (durability == Durability::Fsync) {
+            stats.writeMs = elapsedMs(started);
+            const auto t0 = std::chrono::steady_clock::now();
+            file->sync();
+            stats.fsyncMs = elapsedMs(t0);
+        }
+        file.reset(); // закрити до rename (Windows)
+
+        std::error_code ec;
+        std::filesystem::rename(temp, target, ec);
+        if (ec) {
+            std::filesystem::remove(temp, ec);
+            throw FileSaveError("Не вдається замінити файл: " + target);
+        }
+        if (durability == Durability::Fsync) {
+            const auto t0 = std::chrono::steady_clock::now();
+            syncDirectory(std::filesystem::path(target).parent_path());
+            stats.fsyncMs += elapsedMs(t0);
+        }
+        else {
+            stats.writeMs = elapsedMs(started);
+        }
+        return stats;
+    }
+};
+
+// ===========================
+// SerializeBuffer: буфер, у який пацієнти дописують свій рядок (serializeTo).
+// Пам'ять належить викликачу і перевикористовується: після прогріву — жодних алокацій
+// ===========================
+class SerializeBuffer {
+private:
+    std::vector<char> bytes; // розмір = місткість; зайняті перші used байтів
+    std::size_t used = 0;
+
+    char* reserveTail(std::size_t extra) {
+        if (used + extra > bytes.size()) bytes.resize(std::max(bytes.size() * 2, used + extra));
+        return bytes.data() + used;
+    }
+
+public:
+    explicit SerializeBuffer(std::size_t capacity = 256) : bytes(capacity) {}
+
+    void append(std::string_view text) {
+        std::memcpy(reserveTail(text.size()), text.data(), text.size());
+        used += text.size();
+    }
+
+    void append(char c) {
+        *reserveTail(1) = c;
+        ++used;
+    }
+
+    // Ручне форматування цілого (замість std::to_string — без тимчасового рядка)
+    void appendInt(int value) {
+        char digits[12]; // "-2147483648" — 11 символів
+        char* pos = digits + sizeof(digits);
+        unsigned magnitude = value < 0 ? 0u - static_cast<unsigned>(value) : static_cast<unsigned>(value);
+        do {
+            *--pos = static_cast<char>('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude != 0);
+        if (value < 0) *--pos = '-';
+        append(std::string_view(pos, static_cast<std::size_t>(digits + sizeof(digits) - pos)));
+    }
+
+    std::string_view view() const { return { bytes.data(), used }; }
+    std::size_t size() const { return used; }
+    void clear() { used = 0; }
+};
+
+// ===========================
+// SymbolPool: інтернування повторюваних значень (діагнози, алергії, протипоказання).
+// Кожне різне значення зберігається один раз, пацієнт тримає лише 32-бітний номер символу,
+// а рівність таких полів у межах одного пулу — порівняння номерів. Пул лише росте.
+// intern() потокобезпечний (паралельне завантаження); text() читає без блокування —
+// записи пулу ніколи не переміщуються
+// ===========================
+class SymbolPool {
+public:
+    using Id = std::uint32_t;
+    static constexpr Id kNotFound = ~Id{};
+
+    SymbolPool() = default;
+    SymbolPool(const SymbolPool&) = delete;
+    SymbolPool& operator=(const SymbolPool&) = delete;
+
+    // Пул для пацієнтів поза клінікою (живе до кінця програми)
+    static SymbolPool& global() {
+        static SymbolPool pool;
+        return pool;
+    }
+
+    Id intern(std::string_view value) {
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex); // звичний випадок: значення вже є
+            const auto it = index.find(value);
+            if (it != index.end()) return it->second;
+        }
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        const auto it = index.find(value);
+        if (it != index.end()) return it->second;
+        if (count == kSegmentSize * kMaxSegments) throw std::length_error("SymbolPool: забагато різних значень");
+
+        char* bytes = static_cast<char*>(storage.allocate(value.size() + 1, 1));
+        std::memcpy(bytes, value.data(), value.size());
+        const std::string_view stored(bytes, value.size());
+        auto& segment = segments[count / kSegmentSize];
+        if (!segment) segment = std::make_unique<std::string_view[]>(kSegmentSize);
+        segment[count % kSegmentSize] = stored;
+        index.emplace(stored, count);
+        return count++;
+    }
+
+    // Переносить усі значення цього пулу в to; результат — номер у to для кожного номера
+    // цього пулу (для Patient::remapSymbols без повторного хешування полів кожного запису)
+    std::vector<Id> mergeInto(SymbolPool& to) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        std::vector<Id> remap(count);
+        for (Id id = 0; id < count; ++id) remap[id] = to.intern(text(id));
+        return remap;
+    }
+
+    // Номер наявного значення або kNotFound (без вставки)
+    Id find(std::string_view value) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        const auto it = index.find(value);
+        return it != index.end() ? it->second : kNotFound;
+    }
+
+    std::string_view text(Id id) const { return segments[id / kSegmentSize][id % kSegmentSize]; }
+
+    std::size_t size() const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return count;
+    }
+
+private:
+    static constexpr std::size_t kSegmentSize = 1024;
+    static constexpr std::size_t kMaxSegments = 4096; // до ~4 млн різних значень
+
+    mutable std::shared_mutex mutex;
+    std::unordered_map<std::string_view, Id> index;
+    std::array<std::unique_ptr<std::string_view[]>, kMaxSegments> segments; // не переміщуються при рості
+    std::pmr::monotonic_buffer_resource storage;                             // байти значень
+    Id count = 0;
+};
+
+// ===========================
+// Пам'ять пацієнтів: об'єкт пацієнта і всі його рядки розміщуються в одному
+// std::pmr::memory_resource (за замовчуванням — звичайна купа). Так клініка з ареною
+// бере все з кількох великих блоків і віддає їх цілком, без malloc/free на кожен рядок
+// ===========================
+class Patient;
+
+// Видаляє пацієнта тим ресурсом, з якого його розміщено (ресурс і розмір знає сам об'єкт)
+struct PatientDeleter {
+    void operator()(Patient* p) const noexcept;
+};
+
+using PatientPtr = std::unique_ptr<Patient, PatientDeleter>;
+
+// Розміщує T у resource; рядки T беруть пам'ять із того ж ресурсу
+template <class T, class... Args>
+PatientPtr allocatePatient(std::pmr::memory_resource* resource, Args&&... args) {
+    void* memory = resource->allocate(sizeof(T), alignof(T));
+    try {
+        return PatientPtr(::new (memory) T(std::forward<Args>(args)..., resource));
+    }
+    catch (...) {
+        resource->deallocate(memory, sizeof(T), alignof(T));
+        throw;
+    }
+}
+
 // ===========================
 // БАЗОВА МОДЕЛЬ: Patient (батьківський клас)
 // п.6: поліморфізм (віртуальний деструктор, віртуальні методи)
-// п.8: поліморфне збереження (віртуальний toLine())
+// п.8: поліморфне збереження (віртуальний serializeTo(); toLine() — обгортка над ним)
 // ===========================
 class Patient {
+public:
+    // Останній параметр конструкторів — звідки брати пам'ять рядків (за замовчуванням — купа)
+    using allocator_type = std::pmr::polymorphic_allocator<char>;
+
 private:
-    std::string name;
+    std::pmr::string name;
     int age{};
-    std::string disease;
+    SymbolPool::Id diseaseId{};
+    SymbolPool* symbols; // пул інтернованих полів (діагноз і поля підтипів)
 
 public:
-    // Конструктори
-    Patient() : name("Невідомо"), age(0), disease("Немає") {}
-    Patient(std::string name, int age, std::string disease)
-        : name(std::move(name)), age(age), disease(std::move(disease)) {
+    // Конструктори. Без явного пулу інтернованих полів — SymbolPool::global(); копія без
+    // явного пулу ділить пул оригіналу (номери не переводяться, пул має пережити копію)
+    Patient() : Patient("Невідомо", 0, "Немає") {}
+    Patient(std::string_view name, int age, std::string_view disease, allocator_type alloc = {})
+        : Patient(name, age, disease, SymbolPool::global(), alloc) {
+    }
+    Patient(std::string_view name, int age, std::string_view disease, SymbolPool& symbols, allocator_type alloc)
+        : Patient(name, age, symbols.intern(disease), symbols, alloc) {
+    }
+    // disease — номер значення, вже інтернованого в symbols (завантаження знімка)
+    Patient(std::string_view name, int age, SymbolPool::Id disease, SymbolPool& symbols, allocator_type alloc)
+        : name(name, alloc), age(age), diseaseId(disease), symbols(&symbols) {
+    }
+    Patient(const Patient& other, allocator_type alloc = {})
+        : Patient(other, *other.symbols, alloc) {
     }
-    Patient(const Patient& other)
-        : name(other.name), age(other.age), disease(other.disease) {
+    // Копія в інший пул: номери символів переводяться лише якщо пули різні
+    Patient(const Patient& other, SymbolPool& symbols, allocator_type alloc)
+        : name(other.name, alloc), age(other.age),
+        diseaseId(reintern(other, other.diseaseId, symbols)), symbols(&symbols) {
     }
 
     // Віртуальний деструктор (потрібен для коректного поліморфного видалення)
@@ -40,30 +532,88 @@ public:
     virtual void printInfo() const {
         std::cout << "Пацієнт: " << name
             << ", вік: " << age
-            << ", діагноз: " << disease << "\n";
+            << ", діагноз: " << getDisease() << "\n";
     }
 
-    // Поліморфне клонування (для глибокого копіювання у Polyclinic)
-    virtual std::unique_ptr<Patient> clone() const {
-        return std::make_unique<Patient>(*this);
+    // Поліморфне клонування (для глибокого копіювання у Polyclinic) у заданий ресурс пам'яті і пул
+    virtual PatientPtr clone(std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+        SymbolPool& pool = SymbolPool::global()) const {
+        return allocatePatient<Patient>(resource, *this, pool);
     }
 
     // п.8: поліморфне представлення у вигляді одного рядка для файлу
     // Формат: TYPE|name|age|disease|...
     // Примітка: службовий токен TYPE залишаємо англійською (Patient/Child/Elder)
-    virtual std::string toLine() const {
-        return std::string("Patient") + "|" + name + "|" + std::to_string(age) + "|" + disease;
+    // serializeTo дописує поля прямо в буфер викликача — без проміжних рядків
+    virtual void serializeTo(SerializeBuffer& out) const {
+        out.append("Patient|");
+        serializeCommon(out);
+    }
+
+    // Зручна обгортка: один рядок (одна алокація) для поодиноких викликів
+    std::string toLine() const {
+        SerializeBuffer out;
+        serializeTo(out);
+        return std::string(out.view());
     }
 
+    virtual PatientType type() const { return PatientType::Patient; }
+
     // Доступ до полів
-    const std::string& getName() const { return name; }
+    std::string_view getName() const { return name; }
     int getAge() const { return age; }
-    const std::string& getDisease() const { return disease; }
+    std::string_view getDisease() const { return symbols->text(diseaseId); }
 
-    void setName(const std::string& n) { name = n; }
+    void setName(std::string_view n) { name.assign(n); }
     void setAge(int a) { age = a; }
-    void setDisease(const std::string& d) { disease = d; }
+    void setDisease(std::string_view d) { diseaseId = symbols->intern(d); }
 
+    // Інтерновані поля: номер у пулі та сам пул
+    SymbolPool::Id diseaseSymbol() const { return diseaseId; }
+    const SymbolPool& symbolPool() const { return *symbols; }
+
+    // Переводить інтерновані поля в пул to (наприклад, перед додаванням готового об'єкта в клініку)
+    virtual void rebindSymbols(SymbolPool& to) {
+        diseaseId = reintern(*this, diseaseId, to);
+        symbols = &to;
+    }
+
+    // Те саме, що rebindSymbols, коли номери в to уже відомі: remap = symbolPool().mergeInto(to)
+    virtual void remapSymbols(SymbolPool& to, const std::vector<SymbolPool::Id>& remap) {
+        diseaseId = remap[diseaseId];
+        symbols = &to;
+    }
+
+    // В одному пулі — порівняння номерів, інакше — рядків
+    bool hasSameDisease(const Patient& other) const {
+        return symbols == other.symbols ? diseaseId == other.diseaseId : getDisease() == other.getDisease();
+    }
+
+    std::pmr::memory_resource* memoryResource() const { return name.get_allocator().resource(); }
+
+protected:
+    // Пул, який копія без явного пулу ділить з оригіналом
+    SymbolPool& sharedPool() const { return *symbols; }
+
+    // Номер символу id пацієнта from у пулі to
+    static SymbolPool::Id reintern(const Patient& from, SymbolPool::Id id, SymbolPool& to) {
+        return from.symbols == &to ? id : to.intern(from.symbols->text(id));
+    }
+
+    // Розмір динамічного типу — для PatientDeleter
+    virtual std::size_t objectSize() const { return sizeof(Patient); }
+    friend struct PatientDeleter;
+
+    // Спільна частина рядка: name|age|disease
+    void serializeCommon(SerializeBuffer& out) const {
+        out.append(name);
+        out.append('|');
+        out.appendInt(age);
+        out.append('|');
+        out.append(getDisease());
+    }
+
+public:
     // Порівняння (для повноти; не критично)
     bool operator==(const Patient& other) const { return name == other.name && age == other.age; }
     bool operator!=(const Patient& other) const { return !(*this == other); }
@@ -72,21 +622,37 @@ public:
 // ===========================
 // ПОХІДНИЙ 1: ChildPatient
 // Додаткове поле: контакт батьків; допоміжний метод: потреба дозволу батьків
-// п.8: власна реалізація toLine()
+// п.8: власна реалізація serializeTo()
 // ===========================
 class ChildPatient : public Patient {
 private:
-    std::string parentContact;
+    std::pmr::string parentContact;
 
 public:
     ChildPatient() : Patient(), parentContact("Немає контакту батьків") {}
-    ChildPatient(std::string name, int age, std::string disease, std::string parentContact)
-        : Patient(std::move(name), age, std::move(disease)),
-        parentContact(std::move(parentContact)) {
+    ChildPatient(std::string_view name, int age, std::string_view disease, std::string_view parentContact,
+        allocator_type alloc = {})
+        : ChildPatient(name, age, disease, parentContact, SymbolPool::global(), alloc) {
+    }
+    ChildPatient(std::string_view name, int age, std::string_view disease, std::string_view parentContact,
+        SymbolPool& symbols, allocator_type alloc)
+        : ChildPatient(name, age, symbols.intern(disease), parentContact, symbols, alloc) {
+    }
+    ChildPatient(std::string_view name, int age, SymbolPool::Id disease, std::string_view parentContact,
+        SymbolPool& symbols, allocator_type alloc)
+        : Patient(name, age, disease, symbols, alloc),
+        parentContact(parentContact, alloc) {
+    }
+    ChildPatient(const ChildPatient& other, allocator_type alloc = {})
+        : ChildPatient(other, other.sharedPool(), alloc) {
+    }
+    ChildPatient(const ChildPatient& other, SymbolPool& symbols, allocator_type alloc)
+        : Patient(other, symbols, alloc), parentContact(other.parentContact, alloc) {
     }
 
-    std::unique_ptr<Patient> clone() const override {
-        return std::make_unique<ChildPatient>(*this);
+    PatientPtr clone(std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+        SymbolPool& pool = SymbolPool::global()) const override {
+        return allocatePatient<ChildPatient>(resource, *this, pool);
     }
 
     bool needParentalPermission() const {
@@ -103,165 +669,4188 @@ public:
             << "\n";
     }
 
-    std::string toLine() const override {
-        return std::string("Child") + "|" + getName() + "|" + std::to_string(getAge())
-            + "|" + getDisease() + "|" + parentContact;
+    void serializeTo(SerializeBuffer& out) const override {
+        out.append("Child|");
+        serializeCommon(out);
+        out.append('|');
+        out.append(parentContact);
+    }
+
+    PatientType type() const override { return PatientType::Child; }
+
+    std::string_view getParentContact() const { return parentContact; }
+
+protected:
+    std::size_t objectSize() const override { return sizeof(ChildPatient); }
+};
+
+// ===========================
+// ПОХІДНИЙ 2: ElderPatient
+// Додаткові поля: алергії, протипоказання
+// п.8: власна реалізація serializeTo()
+// ===========================
+class ElderPatient : public Patient {
+private:
+    SymbolPool::Id allergiesId{};         // інтерновані (див. SymbolPool)
+    SymbolPool::Id contraindicationsId{};
+
+public:
+    ElderPatient() : ElderPatient("Невідомо", 0, "Немає", "Немає", "Немає") {}
+    ElderPatient(std::string_view name, int age, std::string_view disease,
+        std::string_view allergies, std::string_view contraindications, allocator_type alloc = {})
+        : ElderPatient(name, age, disease, allergies, contraindications, SymbolPool::global(), alloc) {
+    }
+    ElderPatient(std::string_view name, int age, std::string_view disease,
+        std::string_view allergies, std::string_view contraindications, SymbolPool& symbols, allocator_type alloc)
+        : ElderPatient(name, age, symbols.intern(disease), symbols.intern(allergies), symbols.intern(contraindications),
+            symbols, alloc) {
+    }
+    ElderPatient(std::string_view name, int age, SymbolPool::Id disease,
+        SymbolPool::Id allergies, SymbolPool::Id contraindications, SymbolPool& symbols, allocator_type alloc)
+        : Patient(name, age, disease, symbols, alloc),
+        allergiesId(allergies),
+        contraindicationsId(contraindications) {
+    }
+    ElderPatient(const ElderPatient& other, allocator_type alloc = {})
+        : ElderPatient(other, other.sharedPool(), alloc) {
+    }
+    ElderPatient(const ElderPatient& other, SymbolPool& symbols, allocator_type alloc)
+        : Patient(other, symbols, alloc),
+        allergiesId(reintern(other, other.allergiesId, symbols)),
+        contraindicationsId(reintern(other, other.contraindicationsId, symbols)) {
+    }
+
+    PatientPtr clone(std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+        SymbolPool& pool = SymbolPool::global()) const override {
+        return allocatePatient<ElderPatient>(resource, *this, pool);
+    }
+
+    void printMedicalWarnings() const {
+        std::cout << "  Алергії: " << getAllergies()
+            << " | Протипоказання: " << getContraindications() << "\n";
+    }
+
+    void printInfo() const override {
+        std::cout << "Літній пацієнт: " << getName()
+            << ", вік: " << getAge()
+            << ", діагноз: " << getDisease() << "\n";
+        printMedicalWarnings();
+    }
+
+    void serializeTo(SerializeBuffer& out) const override {
+        out.append("Elder|");
+        serializeCommon(out);
+        out.append('|');
+        out.append(getAllergies());
+        out.append('|');
+        out.append(getContraindications());
+    }
+
+    PatientType type() const override { return PatientType::Elder; }
+
+    void rebindSymbols(SymbolPool& to) override {
+        allergiesId = reintern(*this, allergiesId, to); // поки symbols ще старий
+        contraindicationsId = reintern(*this, contraindicationsId, to);
+        Patient::rebindSymbols(to);
+    }
+
+    void remapSymbols(SymbolPool& to, const std::vector<SymbolPool::Id>& remap) override {
+        allergiesId = remap[allergiesId];
+        contraindicationsId = remap[contraindicationsId];
+        Patient::remapSymbols(to, remap);
+    }
+
+    std::string_view getAllergies() const { return symbolPool().text(allergiesId); }
+    std::string_view getContraindications() const { return symbolPool().text(contraindicationsId); }
+    SymbolPool::Id allergiesSymbol() const { return allergiesId; }
+    SymbolPool::Id contraindicationsSymbol() const { return contraindicationsId; }
+
+protected:
+    std::size_t objectSize() const override { return sizeof(ElderPatient); }
+};
+
+static_assert(alignof(ChildPatient) == alignof(Patient) && alignof(ElderPatient) == alignof(Patient),
+    "PatientDeleter звільняє всі підтипи з вирівнюванням Patient");
+
+inline void PatientDeleter::operator()(Patient* p) const noexcept {
+    std::pmr::memory_resource* resource = p->memoryResource();
+    const std::size_t size = p->objectSize();
+    p->~Patient();
+    resource->deallocate(p, size, alignof(Patient));
+}
+
+// Фабрика для форматів читання (текст, знімок, журнал): будує пацієнта потрібного підтипу
+// в resource (інтерновані поля — у symbols), копіюючи кожен рядок лише один раз.
+// Зайві для підтипу поля ігноруються
+inline PatientPtr makePatient(std::pmr::memory_resource* resource, SymbolPool& symbols, PatientType type,
+    std::string_view name, int age, std::string_view disease,
+    std::string_view extra1 = {}, std::string_view extra2 = {}) {
+    switch (type) {
+    case PatientType::Child:
+        return allocatePatient<ChildPatient>(resource, name, age, disease, extra1, symbols);
+    case PatientType::Elder:
+        return allocatePatient<ElderPatient>(resource, name, age, disease, extra1, extra2, symbols);
+    default:
+        return allocatePatient<Patient>(resource, name, age, disease, symbols);
+    }
+}
+
+// Незмінний спільний запис пацієнта (copy-on-write у Polyclinic)
+using SharedPatient = std::shared_ptr<const Patient>;
+
+// Як makePatient, але одразу спільний запис: об'єкт, рядки і лічильник посилань — одна
+// алокація в resource (allocate_shared передає алокатор у конструктор)
+inline SharedPatient makeSharedPatient(std::pmr::memory_resource* resource, SymbolPool& symbols, PatientType type,
+    std::string_view name, int age, std::string_view disease,
+    std::string_view extra1 = {}, std::string_view extra2 = {}) {
+    switch (type) {
+    case PatientType::Child:
+        return std::allocate_shared<ChildPatient>(std::pmr::polymorphic_allocator<ChildPatient>(resource),
+            name, age, disease, extra1, symbols);
+    case PatientType::Elder:
+        return std::allocate_shared<ElderPatient>(std::pmr::polymorphic_allocator<ElderPatient>(resource),
+            name, age, disease, extra1, extra2, symbols);
+    default:
+        return std::allocate_shared<Patient>(std::pmr::polymorphic_allocator<Patient>(resource),
+            name, age, disease, symbols);
+    }
+}
+
+// Те саме з уже інтернованими в symbols полями (номери); поля, яких підтип не має, ігноруються
+inline SharedPatient makeSharedPatient(std::pmr::memory_resource* resource, SymbolPool& symbols, PatientType type,
+    std::string_view name, int age, SymbolPool::Id disease, std::string_view parentContact,
+    SymbolPool::Id allergies, SymbolPool::Id contraindications) {
+    switch (type) {
+    case PatientType::Child:
+        return std::allocate_shared<ChildPatient>(std::pmr::polymorphic_allocator<ChildPatient>(resource),
+            name, age, disease, parentContact, symbols);
+    case PatientType::Elder:
+        return std::allocate_shared<ElderPatient>(std::pmr::polymorphic_allocator<ElderPatient>(resource),
+            name, age, disease, allergies, contraindications, symbols);
+    default:
+        return std::allocate_shared<Patient>(std::pmr::polymorphic_allocator<Patient>(resource),
+            name, age, disease, symbols);
+    }
+}
+
+// Власний об'єкт -> спільний запис (лічильник посилань — теж у ресурсі пацієнта)
+inline SharedPatient sharePatient(PatientPtr p) {
+    std::pmr::memory_resource* resource = p->memoryResource();
+    return SharedPatient(p.release(), PatientDeleter{}, std::pmr::polymorphic_allocator<char>(resource));
+}
+
+// ===========================
+// Пошук роздільників '|' і '\n' — внутрішній цикл усіх текстових завантажувачів.
+// Блок із 64 байтів перетворюється на бітові маски меж: SSE2 — 4×16 байтів, AVX2 — 2×32,
+// скалярний варіант — для інших процесорів. Реалізація обирається один раз під час
+// виконання за CPUID, тож той самий .exe працює і на машинах без AVX2
+// ===========================
+struct DelimiterMasks {
+    std::uint64_t fields;  // біт i: байт i — '|' або '\n' (межа поля)
+    std::uint64_t records; // біт i: байт i — '\n' (межа запису)
+};
+
+using ScanBlockFn = DelimiterMasks(*)(const char* block);
+constexpr std::size_t kScanBlock = 64;
+
+inline DelimiterMasks scanBlockScalar(const char* p) {
+    DelimiterMasks m{ 0, 0 };
+    for (std::size_t i = 0; i < kScanBlock; ++i) {
+        const std::uint64_t bit = std::uint64_t{ 1 } << i;
+        if (p[i] == '\n') {
+            m.fields |= bit;
+            m.records |= bit;
+        }
+        else if (p[i] == '|') {
+            m.fields |= bit;
+        }
+    }
+    return m;
+}
+
+#ifdef POLYCLINIC_X86
+#if defined(__GNUC__) || defined(__clang__)
+#define POLYCLINIC_TARGET(isa) __attribute__((target(isa)))
+#else
+#define POLYCLINIC_TARGET(isa) // MSVC дозволяє інтринсики без /arch
+#endif
+
+POLYCLINIC_TARGET("sse2") inline DelimiterMasks scanBlockSse2(const char* p) {
+    const __m128i bar = _mm_set1_epi8('|'), nl = _mm_set1_epi8('\n');
+    DelimiterMasks m{ 0, 0 };
+    for (int i = 0; i < 4; ++i) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+        const std::uint64_t isNl = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, nl)));
+        const std::uint64_t isBar = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, bar)));
+        m.records |= isNl << (16 * i);
+        m.fields |= (isNl | isBar) << (16 * i);
+    }
+    return m;
+}
+
+POLYCLINIC_TARGET("avx2") inline DelimiterMasks scanBlockAvx2(const char* p) {
+    const __m256i bar = _mm256_set1_epi8('|'), nl = _mm256_set1_epi8('\n');
+    DelimiterMasks m{ 0, 0 };
+    for (int i = 0; i < 2; ++i) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32 * i));
+        const std::uint64_t isNl = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, nl)));
+        const std::uint64_t isBar = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, bar)));
+        m.records |= isNl << (32 * i);
+        m.fields |= (isNl | isBar) << (32 * i);
+    }
+    return m;
+}
+
+inline bool cpuHasSse2() {
+#if defined(__x86_64__) || defined(_M_X64)
+    return true; // обов'язкова частина x86-64
+#elif defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+#else
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#endif
+}
+
+inline bool cpuHasAvx2() {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0, avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false; // ОС має зберігати регістри YMM
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#endif
+}
+#endif // POLYCLINIC_X86
+
+inline ScanBlockFn selectScanBlock() {
+#ifdef POLYCLINIC_X86
+    if (cpuHasAvx2()) return scanBlockAvx2;
+    if (cpuHasSse2()) return scanBlockSse2;
+#endif
+    return scanBlockScalar;
+}
+
+inline ScanBlockFn activeScanBlock() {
+    static const ScanBlockFn fn = selectScanBlock();
+    return fn;
+}
+
+inline unsigned lowestSetBit(std::uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctzll(x));
+#elif defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return static_cast<unsigned>(index);
+#else
+    unsigned index = 0;
+    while ((x & 1) == 0) { x >>= 1; ++index; }
+    return index;
+#endif
+}
+
+inline unsigned popcount64(std::uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_popcountll(x));
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ull);
+    x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    return static_cast<unsigned>((x * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+// Маски для блоку з позиції pos; неповний останній блок доповнюється нулями
+inline DelimiterMasks scanBlockAt(ScanBlockFn scan, const char* data, std::size_t pos, std::size_t size) {
+    if (size - pos >= kScanBlock) return scan(data + pos);
+    char tail[kScanBlock] = {};
+    std::memcpy(tail, data + pos, size - pos);
+    return scan(tail);
+}
+
+// Послідовно віддає межі полів ('|' і '\n') у [begin, end)
+class DelimiterScanner {
+private:
+    const char* data;
+    std::size_t size;
+    std::size_t blockPos = 0;
+    std::uint64_t pending = 0; // ще не віддані межі поточного блоку
+    ScanBlockFn scan;
+
+public:
+    DelimiterScanner(const char* begin, const char* end)
+        : data(begin), size(static_cast<std::size_t>(end - begin)), scan(activeScanBlock()) {
+        if (size > 0) pending = scanBlockAt(scan, data, 0, size).fields;
+    }
+
+    // Наступна межа; кінець діапазону, якщо меж більше немає
+    const char* next() {
+        while (pending == 0) {
+            blockPos += kScanBlock;
+            if (blockPos >= size) return data + size;
+            pending = scanBlockAt(scan, data, blockPos, size).fields;
+        }
+        const unsigned bit = lowestSetBit(pending);
+        pending &= pending - 1;
+        return data + blockPos + bit;
+    }
+};
+
+// Кількість рядків (записів) в одному проході — щоб зарезервувати список пацієнтів точно
+inline std::size_t countRecords(const char* begin, const char* end) {
+    const ScanBlockFn scan = activeScanBlock();
+    const auto size = static_cast<std::size_t>(end - begin);
+    std::size_t count = 0;
+    for (std::size_t pos = 0; pos < size; pos += kScanBlock) count += popcount64(scanBlockAt(scan, begin, pos, size).records);
+    if (size > 0 && end[-1] != '\n') ++count; // останній рядок без '\n'
+    return count;
+}
+
+// ===========================
+// Розбір формату serializeTo (зворотне до saveToFile)
+// Поля — std::string_view над буфером читання: жодних проміжних рядків,
+// рядки створюються лише один раз — безпосередньо як поля пацієнта
+// ===========================
+constexpr std::size_t kMaxLineFields = 6; // Elder|name|age|disease|allergies|contraindications
+
+inline bool parseAge(std::string_view text, int& age) {
+    const char* end = text.data() + text.size();
+    const auto res = std::from_chars(text.data(), end, age);
+    return res.ec == std::errc{} && res.ptr == end;
+}
+
+// Будує пацієнта з полів одного рядка (n — кількість полів; kMaxLineFields + 1 — забагато).
+// Кидає FileLoadError із номером рядка, якщо формат порушено
+inline SharedPatient patientFromFields(const std::array<std::string_view, kMaxLineFields>& f,
+    std::size_t n, std::string_view line, std::size_t lineNo, std::pmr::memory_resource* resource,
+    SymbolPool& symbols) {
+    int age = 0;
+    if (n < 4 || !parseAge(f[2], age))
+        throw FileLoadError("Некоректний рядок " + std::to_string(lineNo) + ": " + std::string(line));
+
+    if (f[0] == "Patient" && n == 4) return makeSharedPatient(resource, symbols, PatientType::Patient, f[1], age, f[3]);
+    if (f[0] == "Child" && n == 5) return makeSharedPatient(resource, symbols, PatientType::Child, f[1], age, f[3], f[4]);
+    if (f[0] == "Elder" && n == 6) return makeSharedPatient(resource, symbols, PatientType::Elder, f[1], age, f[3], f[4], f[5]);
+
+    throw FileLoadError("Невідомий тип запису у рядку " + std::to_string(lineNo) + ": " + std::string(line));
+}
+
+// Розбирає блок ЦІЛИХ рядків [begin, end) і додає пацієнтів (розміщених у resource,
+// з інтернованими полями в symbols) у out.
+// Межі полів і рядків дає DelimiterScanner (SIMD). firstLineNo — номер першого рядка блоку
+// (для повідомлень); повертає номер наступного рядка
+inline std::size_t parsePatientLines(const char* begin, const char* end, std::size_t firstLineNo,
+    std::vector<SharedPatient>& out, std::pmr::memory_resource* resource, SymbolPool& symbols) {
+    std::array<std::string_view, kMaxLineFields> f;
+    std::size_t n = 0;
+    std::size_t lineNo = firstLineNo;
+    const char* lineStart = begin;
+    const char* fieldStart = begin;
+    DelimiterScanner scanner(begin, end);
+    for (;;) {
+        const char* d = scanner.next();
+        if (n < kMaxLineFields) f[n] = std::string_view(fieldStart, static_cast<std::size_t>(d - fieldStart));
+        if (n <= kMaxLineFields) ++n;
+        fieldStart = d + 1;
+        if (d != end && *d == '|') continue;
+
+        // Кінець рядка ('\n' або кінець блоку); '\r' — файли, збережені у текстовому режимі Windows
+        if (d == end && lineStart == end) break; // після останнього '\n' рядка немає
+        std::string_view line(lineStart, static_cast<std::size_t>(d - lineStart));
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+            if (n <= kMaxLineFields) f[n - 1].remove_suffix(1);
+        }
+        // Порожні рядки пропускаємо; '#' — службовий рядок (позиція журналу, див. saveToFile)
+        if (!line.empty() && line.front() != '#') out.push_back(patientFromFields(f, n, line, lineNo, resource, symbols));
+        ++lineNo;
+        if (d == end) break;
+        lineStart = fieldStart;
+        n = 0;
+    }
+    return lineNo;
+}
+
+// ===========================
+// Бінарний колонковий знімок (Polyclinic::saveSnapshot / loadSnapshot)
+// Формат (порядок байтів платформи — little-endian на x86/ARM; magic виявляє невідповідність):
+//   заголовок: magic u32 | версія u32 | кількість записів u64 | кількість колонок u32 | резерв u32
+//   блоки колонок: id u32 | ширина коду u32 | довжина даних u64 | дані
+//   - Type (u8 на запис) і Age (i32 на запис) — суцільні масиви, читаються одним memcpy
+//   - текстові колонки кодовані словником: розмір словника u32, зсуви u32[розмір + 1],
+//     байти значень, далі коди записів шириною 1/2/4 байти (залежно від розміру словника)
+//   - майже унікальні текстові колонки (ім'я, контакт батьків; з версії 2) — ширина коду 0:
+//     зсуви u32[записи + 1] і байти значень підряд, без словника
+//   - JournalMark (необов'язкова): епоха u32 | резерв u32 | зсув u64 — позиція журналу змін,
+//     яку знімок уже містить (див. MutationJournal)
+// Невідомі id колонок пропускаються — нові версії можуть додавати колонки.
+// ===========================
+enum class SnapshotColumn : std::uint32_t {
+    Type, Age, Name, Disease, ParentContact, Allergies, Contraindications,
+    JournalMark
+};
+
+constexpr std::uint32_t kSnapshotMagic = 0x4E534350; // "PCSN"
+constexpr std::uint32_t kSnapshotVersion = 2; // читаються й знімки версії 1 (усі тексти зі словником)
+constexpr std::uint32_t kSnapshotRequiredColumns = 7; // Type .. Contraindications
+
+template <class T>
+void writePod(AtomicFileWriter& os, const T& value) {
+    os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+inline void writeColumnHeader(AtomicFileWriter& os, SnapshotColumn id, std::uint32_t width, std::uint64_t bytes) {
+    writePod(os, static_cast<std::uint32_t>(id));
+    writePod(os, width);
+    writePod(os, bytes);
+}
+
+// Словникове кодування однієї текстової колонки під час збереження.
+// Ключі — string_view на поля пацієнтів: вони живі, доки триває saveSnapshot
+class DictionaryColumnWriter {
+private:
+    std::unordered_map<std::string_view, std::uint32_t> index;
+    std::vector<std::string_view> values;
+    std::vector<std::uint32_t> codes;
+
+public:
+    // expectedDistinct — підказка для колонок з високою кардинальністю (імена): без неї
+    // хеш-таблиця багато разів перебудовується
+    explicit DictionaryColumnWriter(std::size_t records, std::size_t expectedDistinct = 0) {
+        codes.reserve(records);
+        index.reserve(expectedDistinct);
+        values.reserve(expectedDistinct);
+    }
+
+    void push(std::string_view value) {
+        const auto it = index.try_emplace(value, static_cast<std::uint32_t>(values.size())).first;
+        if (it->second == values.size()) values.push_back(value);
+        codes.push_back(it->second);
+    }
+
+    std::uint32_t codeWidth() const {
+        return values.size() <= 0x100 ? 1 : values.size() <= 0x10000 ? 2 : 4;
+    }
+
+    void writeTo(AtomicFileWriter& os, SnapshotColumn id) const {
+        std::vector<std::uint32_t> offsets;
+        offsets.reserve(values.size() + 1);
+        std::uint32_t total = 0;
+        offsets.push_back(0);
+        for (const auto v : values) offsets.push_back(total += static_cast<std::uint32_t>(v.size()));
+
+        const std::uint32_t width = codeWidth();
+        const std::uint64_t bytes = sizeof(std::uint32_t) * (offsets.size() + 1) + total
+            + static_cast<std::uint64_t>(codes.size()) * width;
+        writeColumnHeader(os, id, width, bytes);
+        writePod(os, static_cast<std::uint32_t>(values.size()));
+        os.write(reinterpret_cast<const char*>(offsets.data()),
+            offsets.size() * sizeof(std::uint32_t));
+        for (const auto v : values) os.write(v.data(), v.size());
+
+        if (width == 4) {
+            os.write(reinterpret_cast<const char*>(codes.data()),
+                codes.size() * sizeof(std::uint32_t));
+            return;
+        }
+        // Звужуємо коди до 1/2 байтів: одна тимчасова колонка і один запис
+        std::vector<char> narrow(codes.size() * width);
+        for (std::size_t i = 0; i < codes.size(); ++i) {
+            if (width == 1) narrow[i] = static_cast<char>(codes[i]);
+            else {
+                const auto c = static_cast<std::uint16_t>(codes[i]);
+                std::memcpy(narrow.data() + i * 2, &c, 2);
+            }
+        }
+        os.write(narrow.data(), narrow.size());
+    }
+};
+
+// Текстова колонка без словника (ширина коду 0): значення записів пишуться підряд. Для майже
+// унікальних колонок словник лише дублює значення і будує хеш-таблицю на кожен запис
+inline void writeRawTextColumn(AtomicFileWriter& os, SnapshotColumn id, const std::vector<std::string_view>& values) {
+    std::vector<std::uint32_t> offsets;
+    offsets.reserve(values.size() + 1);
+    std::uint64_t total = 0;
+    offsets.push_back(0);
+    for (const auto v : values) {
+        total += v.size();
+        if (total > std::numeric_limits<std::uint32_t>::max()) throw FileSaveError("Знімок: текстова колонка понад 4 ГіБ");
+        offsets.push_back(static_cast<std::uint32_t>(total));
+    }
+    writeColumnHeader(os, id, 0, sizeof(std::uint32_t) * offsets.size() + total);
+    os.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(std::uint32_t));
+    for (const auto v : values) os.write(v.data(), v.size());
+}
+
+// Курсор читання бінарних даних (знімок, журнал) з перевіркою меж; кидає FileLoadError
+class BinaryReader {
+private:
+    const char* cur;
+    const char* end;
+
+public:
+    BinaryReader(const char* begin, const char* end) : cur(begin), end(end) {}
+
+    const char* take(std::uint64_t bytes) {
+        if (bytes > static_cast<std::uint64_t>(end - cur)) throw FileLoadError("Пошкоджені дані: неочікуваний кінець файлу");
+        const char* p = cur;
+        cur += bytes;
+        return p;
+    }
+
+    std::uint64_t remaining() const { return static_cast<std::uint64_t>(end - cur); }
+
+    // Лічильник елементів по elementBytes байтів, прочитаний із файлу, перевіряється за
+    // рештою даних ДО будь-якого resize/reserve (інакше пошкоджений байт дає bad_alloc)
+    std::uint64_t checkedCount(std::uint64_t count, std::uint64_t elementBytes) const {
+        if (count > remaining() / elementBytes) throw FileLoadError("Пошкоджені дані: некоректна кількість елементів");
+        return count;
+    }
+
+    template <class T>
+    T read() {
+        T value;
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+        return value;
+    }
+};
+
+// Розкодована текстова колонка: значення словника — string_view на дані знімка. Колонка без
+// словника (ширина 0) має значення на кожен запис і порожні codes
+struct DictionaryColumn {
+    std::vector<std::string_view> values;
+    std::vector<std::uint32_t> codes;
+
+    std::string_view at(std::size_t record) const { return values[codes.empty() ? record : codes[record]]; }
+
+    // Номер у symbols кожного значення (інтернується раз на значення словника, а не на запис)
+    std::vector<SymbolPool::Id> internInto(SymbolPool& symbols) const {
+        std::vector<SymbolPool::Id> ids;
+        ids.reserve(values.size());
+        for (const auto v : values) ids.push_back(symbols.intern(v));
+        return ids;
+    }
+
+    SymbolPool::Id symbolAt(const std::vector<SymbolPool::Id>& ids, std::size_t record) const {
+        return ids[codes.empty() ? record : codes[record]];
+    }
+
+    static DictionaryColumn decode(const char* data, std::uint64_t bytes, std::uint32_t width, std::uint64_t records) {
+        BinaryReader in(data, data + bytes);
+        DictionaryColumn col;
+        if (width == 0) {
+            const auto offsetCount = static_cast<std::size_t>(in.checkedCount(records + 1, sizeof(std::uint32_t)));
+            std::vector<std::uint32_t> offsets(offsetCount);
+            std::memcpy(offsets.data(), in.take(offsetCount * sizeof(std::uint32_t)), offsetCount * sizeof(std::uint32_t));
+            const char* chars = in.take(offsets.back());
+            col.values.reserve(offsetCount - 1);
+            for (std::size_t i = 0; i + 1 < offsetCount; ++i) {
+                if (offsets[i] > offsets[i + 1]) throw FileLoadError("Пошкоджений знімок: некоректні зсуви колонки");
+                col.values.emplace_back(chars + offsets[i], offsets[i + 1] - offsets[i]);
+            }
+            return col;
+        }
+        const auto dictSize = in.read<std::uint32_t>();
+        const auto offsetCount = static_cast<std::size_t>(in.checkedCount(std::uint64_t{ dictSize } + 1, sizeof(std::uint32_t)));
+        const char* rawOffsets = in.take(offsetCount * sizeof(std::uint32_t));
+        std::vector<std::uint32_t> offsets(offsetCount);
+        std::memcpy(offsets.data(), rawOffsets, offsetCount * sizeof(std::uint32_t));
+        const char* chars = in.take(offsets.back());
+        col.values.reserve(dictSize);
+        for (std::uint32_t i = 0; i < dictSize; ++i) {
+            if (offsets[i] > offsets[i + 1]) throw FileLoadError("Пошкоджений знімок: некоректний словник");
+            col.values.emplace_back(chars + offsets[i], offsets[i + 1] - offsets[i]);
+        }
+
+        if (width != 1 && width != 2 && width != 4) throw FileLoadError("Пошкоджений знімок: некоректна ширина коду");
+        const char* raw = in.take(in.checkedCount(records, width) * width);
+        col.codes.resize(static_cast<std::size_t>(records));
+        if (width == 4) std::memcpy(col.codes.data(), raw, col.codes.size() * sizeof(std::uint32_t));
+        else if (width == 2) {
+            for (std::size_t i = 0; i < col.codes.size(); ++i) {
+                std::uint16_t c;
+                std::memcpy(&c, raw + i * 2, 2);
+                col.codes[i] = c;
+            }
+        }
+        else {
+            for (std::size_t i = 0; i < col.codes.size(); ++i) col.codes[i] = static_cast<unsigned char>(raw[i]);
+        }
+        for (const auto c : col.codes)
+            if (c >= dictSize) throw FileLoadError("Пошкоджений знімок: код поза словником");
+        return col;
+    }
+};
+
+// ===========================
+// Журнал змін (write-ahead log) для адміністративних дій
+// Файл: magic u32 | версія u32 | епоха u32 | резерв u32, далі записи
+//   op u8 | довжина даних u32 | дані | контрольна сума u32 (FNV-1a над op, довжиною і даними)
+// Груповий коміт: записи накопичуються в пам'яті й скидаються одним write + fsync раз на
+// groupCommitRecords змін (або явним commit()), тож вартість fsync ділиться між змінами,
+// а кожна зміна коштує O(1) незалежно від кількості пацієнтів.
+// Епоха зростає на кожному checkpoint; знімок зберігає JournalMark (епоха + зсув), тому
+// записи, які вже є у знімку, не відтворюються вдруге навіть після збою посеред checkpoint.
+// ===========================
+enum class JournalOp : std::uint8_t { Add = 1, RemoveAt = 2, RemoveLast = 3, SwapRemoveAt = 4, RemoveIndices = 5, Clear = 6 };
+
+struct JournalMark {
+    std::uint32_t epoch = 0;
+    std::uint64_t offset = 0; // до цього зсуву у журналі епохи epoch зміни вже враховано
+};
+
+constexpr std::uint32_t kJournalMagic = 0x4C4A4350; // "PCJL"
+constexpr std::uint32_t kJournalVersion = 1;
+constexpr std::uint64_t kJournalHeaderSize = 16;
+constexpr std::size_t kJournalRecordOverhead = 1 + 4 + 4; // op + довжина + контрольна сума
+
+inline std::uint32_t fnv1a(const char* data, std::size_t size) {
+    std::uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+template <class T>
+void appendPod(std::vector<char>& out, const T& value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+inline void appendString(std::vector<char>& out, std::string_view value) {
+    appendPod(out, static_cast<std::uint32_t>(value.size()));
+    out.insert(out.end(), value.begin(), value.end());
+}
+
+inline std::string_view readString(BinaryReader& in) {
+    const auto size = in.read<std::uint32_t>();
+    return { in.take(size), size };
+}
+
+class MutationJournal {
+private:
+    AppendFile file;
+    std::uint32_t epoch;
+    std::uint64_t committedBytes;  // байтів уже записано у файл
+    std::vector<char> pending;     // записи, що чекають групового коміту
+    std::size_t pendingRecords = 0;
+    std::size_t groupCommitRecords;
+    std::size_t recordStart = 0;
+
+    void beginRecord(JournalOp op) {
+        recordStart = pending.size();
+        appendPod(pending, static_cast<std::uint8_t>(op));
+        appendPod(pending, std::uint32_t{ 0 }); // довжину допишемо в endRecord
+    }
+
+    void endRecord() {
+        const auto payload = static_cast<std::uint32_t>(pending.size() - recordStart - 5);
+        std::memcpy(pending.data() + recordStart + 1, &payload, sizeof(payload));
+        appendPod(pending, fnv1a(pending.data() + recordStart, pending.size() - recordStart));
+        if (++pendingRecords >= groupCommitRecords) commit();
+    }
+
+    void writeHeader() {
+        std::vector<char> header;
+        appendPod(header, kJournalMagic);
+        appendPod(header, kJournalVersion);
+        appendPod(header, epoch);
+        appendPod(header, std::uint32_t{ 0 });
+        file.write(header.data(), header.size());
+        file.sync();
+        committedBytes = kJournalHeaderSize;
+    }
+
+public:
+    // validBytes — довжина коректного префікса існуючого файлу (пошкоджений хвіст обрізається);
+    // 0 — почати журнал заново з епохою epoch
+    MutationJournal(const std::string& path, std::uint32_t epoch, std::uint64_t validBytes,
+        std::size_t groupCommitRecords)
+        : file(path), epoch(epoch), committedBytes(validBytes),
+        groupCommitRecords(groupCommitRecords == 0 ? 1 : groupCommitRecords) {
+        file.truncate(validBytes);
+        if (validBytes == 0) writeHeader();
+    }
+
+    // Деструктор не кидає: незакомічені записи намагаємося зберегти, помилку ігноруємо
+    ~MutationJournal() {
+        try { commit(); }
+        catch (const FileSaveError&) {}
+    }
+
+    MutationJournal(const MutationJournal&) = delete;
+    MutationJournal& operator=(const MutationJournal&) = delete;
+
+    void logAdd(const Patient& p) {
+        beginRecord(JournalOp::Add);
+        appendPod(pending, static_cast<std::uint8_t>(p.type()));
+        appendPod(pending, static_cast<std::int32_t>(p.getAge()));
+        appendString(pending, p.getName());
+        appendString(pending, p.getDisease());
+        if (p.type() == PatientType::Child) {
+            appendString(pending, static_cast<const ChildPatient&>(p).getParentContact());
+        }
+        else if (p.type() == PatientType::Elder) {
+            const auto& elder = static_cast<const ElderPatient&>(p);
+            appendString(pending, elder.getAllergies());
+            appendString(pending, elder.getContraindications());
+        }
+        endRecord();
+    }
+
+    void logRemoveAt(std::size_t index) {
+        beginRecord(JournalOp::RemoveAt);
+        appendPod(pending, static_cast<std::uint64_t>(index));
+        endRecord();
+    }
+
+    void logRemoveLast() {
+        beginRecord(JournalOp::RemoveLast);
+        endRecord();
+    }
+
+    // Видалення за PatientId: на місце index стає останній пацієнт
+    void logSwapRemoveAt(std::size_t index) {
+        beginRecord(JournalOp::SwapRemoveAt);
+        appendPod(pending, static_cast<std::uint64_t>(index));
+        endRecord();
+    }
+
+    // Масове видалення одним записом: кількість, далі позиції за зростанням
+    void logRemoveIndices(const std::vector<std::size_t>& sortedIndices) {
+        beginRecord(JournalOp::RemoveIndices);
+        appendPod(pending, static_cast<std::uint64_t>(sortedIndices.size()));
+        for (const std::size_t index : sortedIndices) appendPod(pending, static_cast<std::uint64_t>(index));
+        endRecord();
+    }
+
+    // Виписка всіх пацієнтів (клініку злито в іншу)
+    void logClear() {
+        beginRecord(JournalOp::Clear);
+        endRecord();
+    }
+
+    // Груповий коміт: один write і один fsync на всі накопичені записи
+    void commit() {
+        if (pending.empty()) return;
+        file.write(pending.data(), pending.size());
+        file.sync();
+        committedBytes += pending.size();
+        pending.clear();
+        pendingRecords = 0;
+    }
+
+    // Після checkpoint: порожній журнал нової епохи
+    void reset(std::uint32_t newEpoch) {
+        pending.clear();
+        pendingRecords = 0;
+        epoch = newEpoch;
+        file.truncate(0);
+        writeHeader();
+    }
+
+    // Позиція після останньої зміни (включно з незакоміченими — вони вже є в пам'яті)
+    JournalMark position() const { return { epoch, committedBytes + pending.size() }; }
+
+    static bool readEpoch(const MappedFile& file, std::uint32_t& epoch) {
+        if (file.size() < kJournalHeaderSize) return false;
+        BinaryReader in(file.begin(), file.end());
+        if (in.read<std::uint32_t>() != kJournalMagic || in.read<std::uint32_t>() != kJournalVersion) return false;
+        epoch = in.read<std::uint32_t>();
+        return true;
+    }
+
+    static SharedPatient decodePatient(BinaryReader& in, std::pmr::memory_resource* resource, SymbolPool& symbols) {
+        const auto type = static_cast<PatientType>(in.read<std::uint8_t>());
+        const auto age = in.read<std::int32_t>();
+        const auto name = readString(in);
+        const auto disease = readString(in);
+        if (type == PatientType::Child) return makeSharedPatient(resource, symbols, type, name, age, disease, readString(in));
+        if (type == PatientType::Elder) {
+            const auto allergies = readString(in);
+            return makeSharedPatient(resource, symbols, type, name, age, disease, allergies, readString(in));
+        }
+        if (type != PatientType::Patient) throw FileLoadError("Пошкоджений журнал: невідомий тип пацієнта");
+        return makeSharedPatient(resource, symbols, type, name, age, disease);
+    }
+
+    // Перевіряє записи по порядку і викликає apply(op, payload) для тих, що починаються з
+    // fromOffset і далі. Незавершений або пошкоджений хвіст (збій посеред запису) не
+    // застосовується; повертає довжину коректного префікса файлу
+    template <class F>
+    static std::uint64_t replay(const MappedFile& file, std::uint64_t fromOffset, F&& apply) {
+        std::uint64_t offset = kJournalHeaderSize;
+        while (file.size() - offset >= kJournalRecordOverhead) {
+            const char* record = file.begin() + offset;
+            std::uint32_t payload = 0;
+            std::memcpy(&payload, record + 1, sizeof(payload));
+            const std::uint64_t total = kJournalRecordOverhead + static_cast<std::uint64_t>(payload);
+            if (total > file.size() - offset) break;
+            std::uint32_t checksum = 0;
+            std::memcpy(&checksum, record + 5 + payload, sizeof(checksum));
+            if (checksum != fnv1a(record, 5 + static_cast<std::size_t>(payload))) break;
+
+            if (offset >= fromOffset) {
+                BinaryReader in(record + 5, record + 5 + payload);
+                apply(static_cast<JournalOp>(static_cast<std::uint8_t>(record[0])), in);
+            }
+            offset += total;
+        }
+        return offset;
+    }
+};
+
+// Спосіб читання файлу в Polyclinic::loadFromFile
+enum class LoadMode {
+    Stream, // блоками через std::ifstream у буфер, що перевикористовується
+    Mapped, // розбір прямо зі сторінок, відображених у пам'ять (без std::ifstream)
+    Parallel // як Mapped, але файл ділиться на частини по межах рядків, кожна — на своєму ядрі
+};
+
+// Copy-on-write: спільний з іншими власниками об'єкт копіюється перед першою зміною
+template <class T>
+T& detach(std::shared_ptr<T>& shared) {
+    if (shared.use_count() > 1) shared = std::make_shared<T>(*shared);
+    return *shared;
+}
+
+// ===========================
+// SegmentedVector: послідовність сторінок по kChunkSize елементів. Ріст додає нову сторінку
+// і ніколи не переносить існуючі елементи (переноситься лише таблиця вказівників на сторінки,
+// у kChunkSize разів менша), тож вставка не має стрибків затримки на великих розмірах.
+// Сторінка — сира пам'ять: елементи конструюються по одному при вставці, тож і перші звернення
+// до нових сторінок пам'яті ОС розподіляються між вставками, а не припадають на одну.
+// Копія ділить сторінки з оригіналом (copy-on-write): зміна копіює лише свою сторінку, тож
+// копіювання коштує O(n / kChunkSize), а перша зміна після нього — одну сторінку.
+// Довільний доступ — один зсув і маска. Дрібніші сторінки (ChunkShift) — для багатьох малих списків
+// ===========================
+template <class T, std::size_t ChunkShift = 12>
+class SegmentedVector {
+private:
+    static constexpr std::size_t kChunkShift = ChunkShift;
+    static constexpr std::size_t kChunkSize = std::size_t{ 1 } << kChunkShift;
+    static constexpr std::size_t kChunkMask = kChunkSize - 1;
+
+    // Спільна сторінка має однакові живі елементи в усіх власників: будь-яка зміна (зокрема
+    // вставка в її вільну частину) спершу відокремлює сторінку
+    struct Chunk {
+        T* items = static_cast<T*>(::operator new(kChunkSize * sizeof(T)));
+        std::size_t used = 0; // живі елементи — перші used
+
+        Chunk() = default;
+        Chunk(const Chunk& other) : Chunk() {
+            for (; used < other.used; ++used) ::new (static_cast<void*>(items + used)) T(other.items[used]);
+        }
+        Chunk& operator=(const Chunk&) = delete;
+        ~Chunk() {
+            while (used > 0) items[--used].~T();
+            ::operator delete(items);
+        }
+    };
+
+    std::vector<std::shared_ptr<Chunk>> chunks; // живі елементи — перші count; сторінки понад них порожні
+    std::size_t count = 0;
+
+    T* slot(std::size_t index) const { return chunks[index >> kChunkShift]->items + (index & kChunkMask); }
+    T* mutableSlot(std::size_t index) { return detach(chunks[index >> kChunkShift]).items + (index & kChunkMask); }
+
+    // Сторінки other — у кінець без копіювання, якщо count кратний kChunkSize (порожні сторінки
+    // в запасі відкидаються); false — елементи треба дописати по одному
+    bool adoptChunks(const SegmentedVector& other) {
+        if (other.count == 0) return true;
+        if ((count & kChunkMask) != 0) return false;
+        chunks.resize(count >> kChunkShift);
+        chunks.insert(chunks.end(), other.chunks.begin(),
+            other.chunks.begin() + static_cast<std::ptrdiff_t>((other.count + kChunkMask) >> kChunkShift));
+        count += other.count;
+        return true;
+    }
+
+public:
+    template <class Owner, class Value>
+    class Iterator {
+    private:
+        Owner* owner;
+        std::size_t index;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Value*;
+        using reference = Value&;
+
+        Iterator(Owner* owner, std::size_t index) : owner(owner), index(index) {}
+        reference operator*() const { return (*owner)[index]; }
+        pointer operator->() const { return &(*owner)[index]; }
+        Iterator& operator++() { ++index; return *this; }
+        Iterator operator++(int) { Iterator t(*this); ++index; return t; }
+        bool operator==(const Iterator& other) const { return index == other.index; }
+        bool operator!=(const Iterator& other) const { return index != other.index; }
+    };
+    using iterator = Iterator<SegmentedVector, T>;
+    using const_iterator = Iterator<const SegmentedVector, const T>;
+
+    SegmentedVector() = default;
+
+    SegmentedVector(SegmentedVector&& other) noexcept
+        : chunks(std::move(other.chunks)), count(std::exchange(other.count, 0)) {
+    }
+
+    SegmentedVector& operator=(SegmentedVector&& other) noexcept {
+        if (this != &other) {
+            chunks = std::move(other.chunks);
+            count = std::exchange(other.count, 0);
+        }
+        return *this;
+    }
+
+    SegmentedVector(const SegmentedVector& other) = default;
+    SegmentedVector& operator=(const SegmentedVector& other) = default;
+
+    T& operator[](std::size_t index) { return *mutableSlot(index); }
+    const T& operator[](std::size_t index) const { return *slot(index); }
+    T& back() { return *mutableSlot(count - 1); }
+    const T& back() const { return *slot(count - 1); }
+
+    void push_back(T value) {
+        if (count == chunks.size() * kChunkSize) chunks.push_back(std::make_shared<Chunk>());
+        Chunk& chunk = detach(chunks[count >> kChunkShift]);
+        ::new (static_cast<void*>(chunk.items + chunk.used)) T(std::move(value));
+        ++chunk.used;
+        ++count;
+    }
+
+    void pop_back() {
+        Chunk& chunk = detach(chunks[(count - 1) >> kChunkShift]);
+        chunk.items[--chunk.used].~T();
+        --count;
+    }
+
+    // Лишає перші n елементів; сторінки залишаються для наступних вставок. Спільна сторінка,
+    // що відкидається цілком, не копіюється — замість неї стає порожня
+    void truncate(std::size_t n) {
+        while (count > n) {
+            const std::size_t first = (count - 1) & ~kChunkMask;
+            auto& chunk = chunks[first >> kChunkShift];
+            if (first >= n && chunk.use_count() > 1) {
+                chunk = std::make_shared<Chunk>();
+                count = first;
+            }
+            else pop_back();
+        }
+    }
+
+    void clear() { truncate(0); }
+
+    void reserve(std::size_t n) {
+        while (chunks.size() * kChunkSize < n) chunks.push_back(std::make_shared<Chunk>());
+    }
+
+    // Дописує елементи other у кінець. Коли власні елементи займають цілі сторінки, сторінки
+    // other приєднуються без копіювання елементів (спільні, як у копії); інакше елементи копіюються
+    void append(const SegmentedVector& other) {
+        if (!adoptChunks(other)) {
+            for (const T& value : other) push_back(value);
+        }
+    }
+
+    // Те саме, але елементи other переносяться; other лишається порожнім
+    void append(SegmentedVector&& other) {
+        if (!adoptChunks(other)) {
+            for (T& value : other) push_back(std::move(value));
+        }
+        other.chunks.clear();
+        other.count = 0;
+    }
+
+    std::size_t size() const { return count; }
+    std::size_t capacity() const { return chunks.size() * kChunkSize; }
+    bool empty() const { return count == 0; }
+
+    iterator begin() { return { this, 0 }; }
+    iterator end() { return { this, count }; }
+    const_iterator begin() const { return { this, 0 }; }
+    const_iterator end() const { return { this, count }; }
+};
+
+// ===========================
+// SlotMap: щільний масив значень + таблиця слотів із поколіннями.
+// Стабільний SlotId (слот + покоління) переживає будь-які видалення інших елементів;
+// після видалення самого елемента покоління слота зростає, і старий SlotId стає недійсним.
+// Вставка, видалення (eraseSwap) і пошук за SlotId — O(1); значення лежать щільно для сканів.
+// Усі три масиви — SegmentedVector: вставка ніколи не переносить уже додані значення
+// ===========================
+struct SlotId {
+    std::uint32_t slot = 0;
+    std::uint32_t generation = 0; // 0 — ніколи не виданий (SlotId{} завжди недійсний)
+
+    bool operator==(const SlotId& other) const { return slot == other.slot && generation == other.generation; }
+    bool operator!=(const SlotId& other) const { return !(*this == other); }
+};
+
+template <class T>
+class SlotMap {
+private:
+    struct Slot {
+        std::uint32_t dense;      // позиція значення або наступний вільний слот
+        std::uint32_t generation;
+    };
+    static constexpr std::uint32_t kNoSlot = ~std::uint32_t{};
+
+    SegmentedVector<T> values;
+    SegmentedVector<std::uint32_t> denseToSlot; // слот кожного значення
+    SegmentedVector<Slot> slots;
+    std::uint32_t freeHead = kNoSlot;
+
+public:
+    static constexpr std::size_t npos = ~std::size_t{};
+
+    SlotId insert(T value) {
+        values.push_back(std::move(value));
+        return idAt(bindSlot(values.size() - 1));
+    }
+
+    // Позиція значення або npos, якщо id застарів
+    std::size_t indexOf(SlotId id) const {
+        if (id.slot >= slots.size() || slots[id.slot].generation != id.generation) return npos;
+        return slots[id.slot].dense;
+    }
+
+    SlotId idAt(std::size_t index) const { return { denseToSlot[index], slots[denseToSlot[index]].generation }; }
+
+    // SlotId значення, що зараз займає слот slot (слот має бути зайнятим)
+    SlotId idOfSlot(std::uint32_t slot) const { return { slot, slots[slot].generation }; }
+
+    T* find(SlotId id) {
+        const std::size_t index = indexOf(id);
+        return index == npos ? nullptr : &values[index];
+    }
+    const T* find(SlotId id) const {
+        const std::size_t index = indexOf(id);
+        return index == npos ? nullptr : &values[index];
+    }
+
+    // O(1): на місце index переходить останнє значення
+    void eraseSwap(std::size_t index) {
+        releaseSlot(denseToSlot[index]);
+        if (index + 1 != values.size()) {
+            values[index] = std::move(values.back());
+            denseToSlot[index] = denseToSlot.back();
+            slots[denseToSlot[index]].dense = static_cast<std::uint32_t>(index);
+        }
+        values.pop_back();
+        denseToSlot.pop_back();
+    }
+
+    // O(n): порядок решти значень зберігається
+    void eraseOrdered(std::size_t index) {
+        releaseSlot(denseToSlot[index]);
+        for (std::size_t i = index; i + 1 < values.size(); ++i) {
+            values[i] = std::move(values[i + 1]);
+            denseToSlot[i] = denseToSlot[i + 1];
+            slots[denseToSlot[i]].dense = static_cast<std::uint32_t>(i);
+        }
+        values.pop_back();
+        denseToSlot.pop_back();
+    }
+
+    // O(n) за один прохід для будь-якої кількості видалень: sortedIndices — позиції за строгим
+    // зростанням, усі < size(). Порядок решти значень зберігається
+    void eraseSorted(const std::vector<std::size_t>& sortedIndices) {
+        if (sortedIndices.empty()) return;
+        std::size_t out = sortedIndices.front();
+        std::size_t next = 0;
+        for (std::size_t i = out; i < values.size(); ++i) {
+            if (next < sortedIndices.size() && sortedIndices[next] == i) {
+                releaseSlot(denseToSlot[i]);
+                ++next;
+                continue;
+            }
+            values[out] = std::move(values[i]);
+            denseToSlot[out] = denseToSlot[i];
+            slots[denseToSlot[out]].dense = static_cast<std::uint32_t>(out);
+            ++out;
+        }
+        values.truncate(out);
+        denseToSlot.truncate(out);
+    }
+
+    // Обмін усіх значень із replacement (старі опиняються в replacement); усі старі SlotId недійсні
+    void swapValues(std::vector<T>& replacement) {
+        releaseAll();
+        std::vector<T> old;
+        old.reserve(values.size());
+        for (auto& value : values) old.push_back(std::move(value));
+        values.clear();
+        values.reserve(replacement.size());
+        denseToSlot.reserve(replacement.size());
+        for (auto& value : replacement) {
+            values.push_back(std::move(value));
+            bindSlot(values.size() - 1);
+        }
+        replacement.swap(old);
+    }
+
+    void clear() {
+        releaseAll();
+        values.clear();
+    }
+
+    // Дописує значення other (const SlotMap& — копії, SlotMap&& — перенесення) у кінець: слот s
+    // з other стає слотом slotOffset + s, де slotOffset — кількість слотів до злиття (його й
+    // повертає). Покоління і вільні слоти other переносяться; значення — сторінками, якщо можна
+    template <class Other>
+    std::uint32_t append(Other&& other) {
+        const auto slotOffset = static_cast<std::uint32_t>(slots.size());
+        const auto valueOffset = static_cast<std::uint32_t>(values.size());
+        const SlotMap& source = other;
+        slots.reserve(slots.size() + source.slots.size());
+        denseToSlot.reserve(denseToSlot.size() + source.denseToSlot.size());
+        for (const Slot& s : source.slots) slots.push_back(s);
+        for (std::size_t i = 0; i < source.denseToSlot.size(); ++i) {
+            const std::uint32_t s = slotOffset + source.denseToSlot[i];
+            slots[s].dense = valueOffset + static_cast<std::uint32_t>(i);
+            denseToSlot.push_back(s);
+        }
+        if (source.freeHead != kNoSlot) { // вільні слоти other — попереду власних
+            std::uint32_t s = source.freeHead;
+            for (; source.slots[s].dense != kNoSlot; s = source.slots[s].dense) slots[slotOffset + s].dense += slotOffset;
+            slots[slotOffset + s].dense = freeHead;
+            freeHead = slotOffset + source.freeHead;
+        }
+        values.append(std::forward<Other>(other).values);
+        if constexpr (!std::is_lvalue_reference_v<Other>) other = SlotMap(); // перенесене — порожнє
+        return slotOffset;
+    }
+
+    void reserve(std::size_t n) {
+        values.reserve(n);
+        denseToSlot.reserve(n);
+    }
+
+    // Місце ще для extra значень; росте геометрично, тож серія злиттів не стає квадратичною
+    void reserveMore(std::size_t extra) {
+        const std::size_t needed = values.size() + extra;
+        if (needed > values.capacity()) reserve(std::max(needed, values.capacity() * 2));
+    }
+
+    std::size_t size() const { return values.size(); }
+    bool empty() const { return values.empty(); }
+    bool neverIssuedIds() const { return slots.empty(); } // жоден SlotId ще не видано
+    T& operator[](std::size_t index) { return values[index]; }
+    const T& operator[](std::size_t index) const { return values[index]; }
+    auto begin() { return values.begin(); }
+    auto end() { return values.end(); }
+    auto begin() const { return values.begin(); }
+    auto end() const { return values.end(); }
+
+private:
+    // Вільний (або новий) слот для значення на позиції index; повертає index
+    std::size_t bindSlot(std::size_t index) {
+        std::uint32_t s = freeHead;
+        if (s != kNoSlot) freeHead = slots[s].dense;
+        else {
+            s = static_cast<std::uint32_t>(slots.size());
+            slots.push_back({ 0, 1 });
+        }
+        slots[s].dense = static_cast<std::uint32_t>(index);
+        denseToSlot.push_back(s);
+        return index;
+    }
+
+    // Нове покоління робить старі SlotId недійсними; слот із вичерпаним лічильником більше не видається
+    void releaseSlot(std::uint32_t s) {
+        if (++slots[s].generation == 0) return;
+        slots[s].dense = freeHead;
+        freeHead = s;
+    }
+
+    // Звільняє слоти всіх значень. Поштучне releaseSlot склало б список у зворотному порядку
+    // (наступне заповнення отримало б слоти n-1..0 і розвернуло б порядок колонок та індексів),
+    // тому список будується наново за зростанням: нові значення знову займають слоти 0, 1, 2, ...
+    void releaseAll() {
+        for (const std::uint32_t s : std::as_const(denseToSlot)) ++slots[s].generation;
+        denseToSlot.clear();
+        freeHead = kNoSlot;
+        for (std::size_t s = slots.size(); s-- > 0;) {
+            if (slots[s].generation == 0) continue; // лічильник вичерпано — слот більше не видається
+            slots[s].dense = freeHead;
+            freeHead = static_cast<std::uint32_t>(s);
+        }
+    }
+};
+
+using PatientId = SlotId;
+
+// ===========================
+// NameIndex: хеш-індекс імен для записів SlotMap з лінійним хешуванням (Litwin): таблиця
+// росте по одному кошику за вставку, тож немає повного перехешування і стрибків затримки.
+// Ланцюжки зв'язані номерами слотів SlotMap: на слот — 32-бітний хеш імені, наступний слот
+// і покоління. Самі рядки індекс не зберігає — збіг імені перевіряє власник
+// ===========================
+class NameIndex {
+private:
+    static constexpr std::uint32_t kNone = ~std::uint32_t{};
+    static constexpr std::size_t kInitialBuckets = 64;
+
+    struct Link {
+        std::uint32_t hash;
+        std::uint32_t next;
+        std::uint32_t generation;
+    };
+
+    SegmentedVector<std::uint32_t> heads; // перший слот ланцюжка кожного кошика
+    SegmentedVector<Link> links;          // за номером слота
+    std::size_t entries = 0;
+    std::size_t level = kInitialBuckets;  // кошиків на початку раунду поділів (степінь двійки)
+    std::size_t split = 0;                // наступний кошик для поділу
+
+    std::size_t bucketOf(std::uint32_t hash) const {
+        const std::size_t bucket = hash & (level - 1);
+        return bucket < split ? hash & (2 * level - 1) : bucket;
+    }
+
+    // Ланцюжок кошика split ділиться між ним і новим кошиком split + level за наступним бітом хешу
+    void splitOne() {
+        std::uint32_t s = heads[split];
+        heads[split] = kNone;
+        heads.push_back(kNone);
+        while (s != kNone) {
+            const std::uint32_t next = links[s].next;
+            const std::size_t target = (links[s].hash & level) ? split + level : split;
+            links[s].next = heads[target];
+            heads[target] = s;
+            s = next;
+        }
+        if (++split == level) {
+            level *= 2;
+            split = 0;
+        }
+    }
+
+public:
+    static std::uint32_t hashOf(std::string_view name) {
+        const auto h = static_cast<std::uint64_t>(std::hash<std::string_view>{}(name));
+        return static_cast<std::uint32_t>(h ^ (h >> 32));
+    }
+
+    void insert(SlotId id, std::string_view name) { insertHashed(id, hashOf(name)); }
+
+    void insertHashed(SlotId id, std::uint32_t hash) {
+        if (heads.empty()) {
+            for (std::size_t i = 0; i < kInitialBuckets; ++i) heads.push_back(kNone);
+        }
+        while (links.size() <= id.slot) links.push_back({ 0, kNone, 0 });
+        const std::size_t bucket = bucketOf(hash);
+        links[id.slot] = { hash, heads[bucket], id.generation };
+        heads[bucket] = id.slot;
+        if (++entries > heads.size()) splitOne(); // у середньому не більше одного запису на кошик
+    }
+
+    // Заміна вмісту count записами; entryAt(i) — пара (SlotId, ім'я) i-го. Кошиків одразу
+    // стільки, скільки записів (степінь двійки), тож кожен запис лише стає в голову свого ланцюжка
+    // без жодного поділу, а сторінки links виділяються наперед
+    template <class EntryAt>
+    void build(std::size_t count, EntryAt&& entryAt) {
+        clear();
+        while (level < count) level *= 2;
+        for (std::size_t i = 0; i < level; ++i) heads.push_back(kNone);
+        links.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            const auto [id, name] = entryAt(i);
+            while (links.size() <= id.slot) links.push_back({ 0, kNone, 0 });
+            const std::uint32_t hash = hashOf(name);
+            const std::size_t bucket = hash & (level - 1);
+            links[id.slot] = { hash, heads[bucket], id.generation };
+            heads[bucket] = id.slot;
+        }
+        entries = count;
+    }
+
+    // Записи other зі слотами, зсунутими на slotOffset (див. SlotMap::append). Хеші імен
+    // беруться з other, тож рядки не читаються і не хешуються вдруге
+    void append(const NameIndex& other, std::uint32_t slotOffset) {
+        links.reserve(static_cast<std::size_t>(slotOffset) + other.links.size());
+        for (std::size_t b = 0; b < other.heads.size(); ++b) {
+            for (std::uint32_t s = other.heads[b]; s != kNone; s = other.links[s].next)
+                insertHashed(SlotId{ slotOffset + s, other.links[s].generation }, other.links[s].hash);
+        }
+    }
+
+    // name — ім'я, з яким id додано
+    void erase(SlotId id, std::string_view name) {
+        if (heads.empty()) return;
+        std::uint32_t* link = &heads[bucketOf(hashOf(name))];
+        while (*link != kNone) {
+            if (*link == id.slot) {
+                *link = links[id.slot].next;
+                --entries;
+                return;
+            }
+            link = &links[*link].next;
+        }
+    }
+
+    // Викликає f(SlotId) для кожного запису з тим самим хешем імені (можливі хибні збіги)
+    template <class F>
+    void forEachCandidate(std::string_view name, F&& f) const {
+        if (heads.empty()) return;
+        const std::uint32_t hash = hashOf(name);
+        for (std::uint32_t s = heads[bucketOf(hash)]; s != kNone; s = links[s].next) {
+            if (links[s].hash == hash) f(SlotId{ s, links[s].generation });
+        }
+    }
+
+    void clear() {
+        heads.clear();
+        links.clear();
+        entries = 0;
+        level = kInitialBuckets;
+        split = 0;
+    }
+};
+
+// ===========================
+// AgeIndex: записи SlotMap, розкладені по кошиках року віку (0..kMaxAge, окремо — вік поза
+// цим діапазоном разом із точним віком кожного запису). Кількість за одним віком — O(1),
+// за діапазоном — дерево Фенвіка над розмірами кошиків (O(log kMaxAge)) плюс перегляд
+// записів поза діапазоном (зазвичай їх немає). Видалення — O(1): на місце запису в кошику
+// стає останній, позиція кожного слота в його кошику зберігається
+// ===========================
+class AgeIndex {
+public:
+    static constexpr int kMaxAge = 150;
+
+private:
+    static constexpr std::size_t kAgeBuckets = kMaxAge + 1;
+    static constexpr std::size_t kOutliers = kAgeBuckets; // вік < 0 або > kMaxAge
+
+    std::array<SegmentedVector<SlotId, 8>, kAgeBuckets + 1> buckets; // сторінки по 2 КіБ
+    SegmentedVector<int, 8> outlierAges;                  // вік кожного запису кошика kOutliers
+    std::array<std::uint32_t, kAgeBuckets + 1> fenwick{}; // 1-базне, лише кошики 0..kMaxAge
+    SegmentedVector<std::uint32_t> positions;             // за номером слота
+
+    static std::size_t bucketOf(int age) {
+        return age < 0 || age > kMaxAge ? kOutliers : static_cast<std::size_t>(age);
+    }
+
+    void adjust(std::size_t bucket, std::uint32_t delta) { // delta за модулем 2^32 (−1 = ~0u)
+        if (bucket == kOutliers) return;
+        for (std::size_t i = bucket + 1; i <= kAgeBuckets; i += i & (~i + 1)) fenwick[i] += delta;
+    }
+
+    // Кількість записів із віком 0..age-1
+    std::size_t countBelow(std::size_t age) const {
+        std::size_t total = 0;
+        for (std::size_t i = age; i > 0; i -= i & (~i + 1)) total += fenwick[i];
+        return total;
+    }
+
+    // f(SlotId) для записів поза 0..kMaxAge із віком у [lo, hi] і знаком negative
+    template <class F>
+    void forEachOutlier(int lo, int hi, bool negative, F&& f) const {
+        const auto& members = buckets[kOutliers];
+        for (std::size_t i = 0; i < members.size(); ++i) {
+            const int age = outlierAges[i];
+            if ((age < 0) == negative && age >= lo && age <= hi) f(members[i]);
+        }
+    }
+
+public:
+    void insert(SlotId id, int age) {
+        const std::size_t bucket = bucketOf(age);
+        while (positions.size() <= id.slot) positions.push_back(0);
+        positions[id.slot] = static_cast<std::uint32_t>(buckets[bucket].size());
+        buckets[bucket].push_back(id);
+        if (bucket == kOutliers) outlierAges.push_back(age);
+        adjust(bucket, 1);
+    }
+
+    // Заміна вмісту count записами; entryAt(i) — пара (SlotId, вік) i-го. Дерево Фенвіка
+    // будується один раз за O(kMaxAge) з готових розмірів кошиків, а не оновлюється на кожен запис
+    template <class EntryAt>
+    void build(std::size_t count, EntryAt&& entryAt) {
+        clear();
+        positions.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            const auto [id, age] = entryAt(i);
+            const std::size_t bucket = bucketOf(age);
+            while (positions.size() <= id.slot) positions.push_back(0);
+            positions[id.slot] = static_cast<std::uint32_t>(buckets[bucket].size());
+            buckets[bucket].push_back(id);
+            if (bucket == kOutliers) outlierAges.push_back(age);
+        }
+        for (std::size_t i = 1; i <= kAgeBuckets; ++i) {
+            fenwick[i] += static_cast<std::uint32_t>(buckets[i - 1].size());
+            const std::size_t parent = i + (i & (~i + 1));
+            if (parent <= kAgeBuckets) fenwick[parent] += fenwick[i];
+        }
+    }
+
+    // Записи other зі слотами, зсунутими на slotOffset (див. SlotMap::append): кошики дописуються
+    // кошиками, дерево Фенвіка оновлюється один раз на кошик
+    void append(const AgeIndex& other, std::uint32_t slotOffset) {
+        positions.reserve(static_cast<std::size_t>(slotOffset) + other.positions.size());
+        for (std::size_t bucket = 0; bucket < buckets.size(); ++bucket) {
+            for (const SlotId id : other.buckets[bucket]) {
+                const SlotId moved{ slotOffset + id.slot, id.generation };
+                while (positions.size() <= moved.slot) positions.push_back(0);
+                positions[moved.slot] = static_cast<std::uint32_t>(buckets[bucket].size());
+                buckets[bucket].push_back(moved);
+            }
+            adjust(bucket, static_cast<std::uint32_t>(other.buckets[bucket].size()));
+        }
+        outlierAges.append(other.outlierAges);
+    }
+
+    // age — вік, з яким id додано
+    void erase(SlotId id, int age) {
+        const std::size_t bucket = bucketOf(age);
+        auto& members = buckets[bucket];
+        const std::uint32_t pos = positions[id.slot];
+        members[pos] = members.back();
+        positions[members[pos].slot] = pos;
+        members.pop_back();
+        if (bucket == kOutliers) {
+            outlierAges[pos] = outlierAges.back();
+            outlierAges.pop_back();
+        }
+        adjust(bucket, ~std::uint32_t{ 0 });
+    }
+
+    // Записи з віком рівно age (будь-яким, зокрема поза 0..kMaxAge)
+    std::size_t countAt(int age) const { return countInRange(age, age); }
+
+    // Записи віком у [lo, hi]
+    std::size_t countInRange(int lo, int hi) const {
+        if (lo > hi) return 0;
+        std::size_t total = 0;
+        const auto tally = [&](SlotId) { ++total; };
+        forEachOutlier(lo, hi, true, tally);
+        forEachOutlier(lo, hi, false, tally);
+        const int from = std::max(lo, 0);
+        const int to = std::min(hi, kMaxAge);
+        if (from <= to) total += countBelow(static_cast<std::size_t>(to) + 1) - countBelow(static_cast<std::size_t>(from));
+        return total;
+    }
+
+    // f(SlotId) для записів віком у [lo, hi] за зростанням віку (у межах одного віку, а також
+    // серед записів поза 0..kMaxAge порядок не визначено)
+    template <class F>
+    void forEachInRange(int lo, int hi, F&& f) const {
+        forEachOutlier(lo, hi, true, f);
+        for (int age = std::max(lo, 0); age <= std::min(hi, kMaxAge); ++age) {
+            for (const SlotId id : buckets[static_cast<std::size_t>(age)]) f(id);
+        }
+        forEachOutlier(lo, hi, false, f);
+    }
+
+    void clear() {
+        for (auto& bucket : buckets) bucket.clear();
+        outlierAges.clear();
+        fenwick.fill(0);
+        positions.clear();
+    }
+};
+
+// ===========================
+// Терми для пошуку за текстом: слова в нижньому регістрі (ASCII і кирилиця, зокрема Є/І/Ї/Ґ).
+// Слово — послідовність літер і цифр; апостроф (' ’ ʼ) між літерами лишається частиною
+// слова й записується як '. Некоректний UTF-8 вважається роздільником
+// ===========================
+inline char32_t decodeUtf8(std::string_view text, std::size_t& i) {
+    const auto lead = static_cast<unsigned char>(text[i++]);
+    if (lead < 0x80) return lead;
+    const int extra = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : -1;
+    if (extra < 0 || i + static_cast<std::size_t>(extra) > text.size()) return 0xFFFD;
+    char32_t cp = lead & (0x3F >> extra);
+    for (int k = 0; k < extra; ++k) {
+        const auto c = static_cast<unsigned char>(text[i]);
+        if ((c & 0xC0) != 0x80) return 0xFFFD;
+        cp = (cp << 6) | (c & 0x3F);
+        ++i;
+    }
+    return cp;
+}
+
+inline void appendUtf8(std::string& out, char32_t cp) {
+    if (cp < 0x80) out += static_cast<char>(cp);
+    else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+inline char32_t lowerCodepoint(char32_t cp) {
+    if (cp >= U'A' && cp <= U'Z') return cp + 0x20;
+    if (cp >= 0x410 && cp <= 0x42F) return cp + 0x20;                  // А..Я
+    if (cp >= 0x400 && cp <= 0x40F) return cp + 0x50;                  // Ѐ..Џ, зокрема Є, І, Ї
+    if (cp >= 0x490 && cp <= 0x4BF && cp % 2 == 0) return cp + 1;      // Ґ і розширена кирилиця
+    return cp;
+}
+
+inline bool isWordCodepoint(char32_t cp) {
+    if (cp < 0x80) return (cp >= U'0' && cp <= U'9') || (cp >= U'a' && cp <= U'z') || (cp >= U'A' && cp <= U'Z');
+    return (cp >= 0xC0 && cp <= 0x24F && cp != 0xD7 && cp != 0xF7) || (cp >= 0x400 && cp <= 0x4FF);
+}
+
+inline bool isApostrophe(char32_t cp) { return cp == U'\'' || cp == 0x2019 || cp == 0x2BC; }
+
+// f(std::string_view term) для кожного слова text; term — у буфері term (перевикористовується)
+template <class F>
+void forEachTerm(std::string_view text, std::string& term, F&& f) {
+    term.clear();
+    std::size_t i = 0;
+    while (i < text.size()) {
+        const char32_t cp = decodeUtf8(text, i);
+        if (isWordCodepoint(cp)) {
+            appendUtf8(term, lowerCodepoint(cp));
+            continue;
+        }
+        if (isApostrophe(cp) && !term.empty() && i < text.size()) {
+            std::size_t next = i;
+            if (isWordCodepoint(decodeUtf8(text, next))) {
+                term += '\'';
+                continue;
+            }
+        }
+        if (!term.empty()) {
+            f(std::string_view(term));
+            term.clear();
+        }
+    }
+    if (!term.empty()) f(std::string_view(term));
+}
+
+// varint: 7 бітів на байт, старший біт — «далі ще байт»
+inline void putVarint(std::vector<unsigned char>& out, std::uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+inline std::uint32_t readVarint(const unsigned char*& p) {
+    std::uint32_t value = 0;
+    for (int shift = 0;; shift += 7) {
+        const unsigned char byte = *p++;
+        value |= static_cast<std::uint32_t>(byte & 0x7F) << shift;
+        if (byte < 0x80) return value;
+    }
+}
+
+// ===========================
+// PostingList: відсортовані номери слотів, стиснуті блоками до kMaxBlock значень —
+// перше значення блоку як є, далі varint різниць (1–2 байти на запис замість 4).
+// Таблиця блоків (перше/останнє значення) дає пропуск цілих блоків при перетині.
+// Вставка в кінець — O(1), у середину й видалення перекодовують лише один блок.
+// Копія ділить блоки з оригіналом: зміна копіює лише свій блок
+// ===========================
+class PostingList {
+public:
+    static constexpr std::size_t kMaxBlock = 128;
+
+private:
+    struct Block {
+        std::uint32_t first = 0;
+        std::uint32_t last = 0;
+        std::uint32_t count = 0;
+        std::vector<unsigned char> deltas; // count - 1 різниць
+    };
+
+    std::vector<std::shared_ptr<Block>> blocks; // копія списку ділить блоки; зміна відокремлює свій
+    std::size_t total = 0;
+
+    static std::size_t decode(const Block& block, std::uint32_t* out) {
+        const unsigned char* p = block.deltas.data();
+        out[0] = block.first;
+        for (std::uint32_t i = 1; i < block.count; ++i) {
+            out[i] = out[i - 1] + readVarint(p);
+        }
+        return block.count;
+    }
+
+    static void encode(Block& block, const std::uint32_t* values, std::size_t n) {
+        block.first = values[0];
+        block.last = values[n - 1];
+        block.count = static_cast<std::uint32_t>(n);
+        block.deltas.clear();
+        for (std::size_t i = 1; i < n; ++i) putVarint(block.deltas, values[i] - values[i - 1]);
+    }
+
+    // Останній блок, що починається не пізніше value (0, якщо такого немає)
+    std::size_t blockFor(std::uint32_t value) const {
+        const auto it = std::upper_bound(blocks.begin(), blocks.end(), value,
+            [](std::uint32_t v, const std::shared_ptr<Block>& b) { return v < b->first; });
+        return it == blocks.begin() ? 0 : static_cast<std::size_t>(it - blocks.begin()) - 1;
+    }
+
+public:
+    void insert(std::uint32_t value) {
+        if (blocks.empty() || value > blocks.back()->last) {
+            if (blocks.empty() || blocks.back()->count == kMaxBlock) {
+                blocks.push_back(std::make_shared<Block>());
+                blocks.back()->first = value;
+            }
+            else putVarint(detach(blocks.back()).deltas, value - blocks.back()->last);
+            Block& last = detach(blocks.back());
+            last.last = value;
+            ++last.count;
+            ++total;
+            return;
+        }
+        const std::size_t b = blockFor(value);
+        std::uint32_t values[kMaxBlock + 1];
+        const std::size_t n = decode(*blocks[b], values);
+        std::uint32_t* pos = std::lower_bound(values, values + n, value);
+        if (pos != values + n && *pos == value) return;
+        std::copy_backward(pos, values + n, values + n + 1);
+        *pos = value;
+        ++total;
+        if (n + 1 <= kMaxBlock) {
+            encode(detach(blocks[b]), values, n + 1);
+            return;
+        }
+        const std::size_t half = (n + 1) / 2; // переповнений блок ділиться навпіл
+        blocks.insert(blocks.begin() + static_cast<std::ptrdiff_t>(b) + 1, std::make_shared<Block>());
+        encode(detach(blocks[b]), values, half);
+        encode(*blocks[b + 1], values + half, n + 1 - half);
+    }
+
+    // Замінює вміст значеннями sorted (строго за зростанням): блоки кодуються підряд, повними
+    void assign(const std::vector<std::uint32_t>& sorted) {
+        blocks.clear();
+        blocks.reserve((sorted.size() + kMaxBlock - 1) / kMaxBlock);
+        for (std::size_t from = 0; from < sorted.size(); from += kMaxBlock) {
+            blocks.push_back(std::make_shared<Block>());
+            encode(*blocks.back(), sorted.data() + from, std::min(kMaxBlock, sorted.size() - from));
+        }
+        total = sorted.size();
+    }
+
+    // Дописує значення other, зсунуті на offset (мають бути більші за всі наявні): блоки
+    // переносяться з тими самими різницями, змінюються лише їхні перше й останнє значення
+    void append(const PostingList& other, std::uint32_t offset) {
+        blocks.reserve(blocks.size() + other.blocks.size());
+        for (const auto& block : other.blocks) {
+            auto moved = std::make_shared<Block>(*block);
+            moved->first += offset;
+            moved->last += offset;
+            blocks.push_back(std::move(moved));
+        }
+        total += other.total;
+    }
+
+    void erase(std::uint32_t value) {
+        if (blocks.empty()) return;
+        const std::size_t b = blockFor(value);
+        std::uint32_t values[kMaxBlock];
+        const std::size_t n = decode(*blocks[b], values);
+        std::uint32_t* pos = std::lower_bound(values, values + n, value);
+        if (pos == values + n || *pos != value) return;
+        std::copy(pos + 1, values + n, pos);
+        --total;
+        if (n == 1) blocks.erase(blocks.begin() + static_cast<std::ptrdiff_t>(b));
+        else encode(detach(blocks[b]), values, n - 1);
+    }
+
+    std::size_t size() const { return total; }
+    bool empty() const { return total == 0; }
+
+    // Послідовний обхід із перескоком: advanceTo пропускає блоки, що закінчуються раніше за ціль,
+    // а всередині блоку розкодовує різниці лише до потрібного значення
+    class Cursor {
+    private:
+        const PostingList* list;
+        std::size_t block = 0;
+        const unsigned char* pending = nullptr; // наступна нерозкодована різниця
+        std::uint32_t remaining = 0;          // скільки різниць лишилось у блоці
+        std::uint32_t current = 0;
+        bool atEnd = false;
+
+        void load(std::size_t b) {
+            block = b;
+            atEnd = b >= list->blocks.size();
+            if (atEnd) return;
+            const Block& blk = *list->blocks[b];
+            current = blk.first;
+            pending = blk.deltas.data();
+            remaining = blk.count - 1;
+        }
+
+        void step() {
+            current += readVarint(pending);
+            --remaining;
+        }
+
+    public:
+        explicit Cursor(const PostingList& list) : list(&list) { load(0); }
+
+        bool valid() const { return !atEnd; }
+        std::uint32_t value() const { return current; }
+
+        void next() {
+            if (remaining > 0) step();
+            else load(block + 1);
+        }
+
+        // Перше значення >= target
+        void advanceTo(std::uint32_t target) {
+            if (atEnd || current >= target) return;
+            if (list->blocks[block]->last < target) {
+                const auto it = std::lower_bound(list->blocks.begin() + static_cast<std::ptrdiff_t>(block) + 1,
+                    list->blocks.end(), target, [](const std::shared_ptr<Block>& b, std::uint32_t t) { return b->last < t; });
+                load(static_cast<std::size_t>(it - list->blocks.begin()));
+                if (atEnd) return;
+            }
+            while (current < target) step(); // last >= target, тож блок не закінчиться раніше
+        }
+    };
+
+    // Перетин за схемою leapfrog: найкоротший список веде, решта перескакують до його значень
+    static std::vector<std::uint32_t> intersect(std::vector<const PostingList*> lists) {
+        std::vector<std::uint32_t> out;
+        if (lists.empty()) return out;
+        std::sort(lists.begin(), lists.end(), [](const PostingList* a, const PostingList* b) { return a->size() < b->size(); });
+        std::vector<Cursor> cursors;
+        cursors.reserve(lists.size());
+        for (const PostingList* list : lists) cursors.emplace_back(*list);
+        Cursor& lead = cursors[0];
+        while (lead.valid()) {
+            const std::uint32_t candidate = lead.value();
+            bool everywhere = true;
+            for (std::size_t k = 1; k < cursors.size(); ++k) {
+                cursors[k].advanceTo(candidate);
+                if (!cursors[k].valid()) return out;
+                if (cursors[k].value() != candidate) {
+                    lead.advanceTo(cursors[k].value());
+                    everywhere = false;
+                    break;
+                }
+            }
+            if (everywhere) {
+                out.push_back(candidate);
+                lead.next();
+            }
+        }
+        return out;
+    }
+};
+
+// Текстові поля пацієнта, що потрапляють в інвертований індекс
+enum class TermField : std::uint8_t { Disease, Allergies, Contraindications };
+
+// Умова пошуку: усі слова text мають бути в полі field
+struct TermClause {
+    TermField field;
+    std::string_view text;
+};
+
+// ===========================
+// TermIndex: інвертований індекс «поле + терм → PostingList номерів слотів SlotMap»
+// для діагнозу, алергій і протипоказань. Інтерновані тексти розбираються на слова один раз:
+// для (пул, поле, номер символу) запам'ятовуються номери списків, тож вставка й видалення
+// пацієнта не токенізують і не хешують рядки. Пули всіх записів мають жити до clear()
+// (у Polyclinic їх тримають клініка і PatientTable::pools)
+// ===========================
+class TermIndex {
+private:
+    static constexpr std::uint32_t kNotParsed = ~std::uint32_t{};
+    static constexpr std::size_t kFields = 3;
+
+    struct PoolCache {
+        std::array<std::vector<std::uint32_t>, kFields> start; // за номером символу: зсув у data
+        std::vector<std::uint32_t> data;                        // [кількість, номери списків...]
+    };
+
+    // Словник термів і розібрані тексти пулів росте лише з новими словами й символами, тож
+    // копії індексу ділять його, доки одна з них не зустріне ще не розібраний текст
+    struct Vocabulary {
+        std::unordered_map<std::string, std::uint32_t> termIds; // ключ: байт поля + терм
+        std::unordered_map<const SymbolPool*, PoolCache> caches;
+    };
+
+    std::shared_ptr<Vocabulary> vocabulary = std::make_shared<Vocabulary>();
+    std::vector<std::shared_ptr<PostingList>> lists; // копія ділить списки; зміна відокремлює свій
+    std::string key;                                 // буфери ключа й терма, перевикористовуються
+    std::string term;
+    const SymbolPool* lastPool = nullptr;            // останній пул — без пошуку в caches
+    PoolCache* lastCache = nullptr;
+
+    template <class F>
+    static void forEachField(const Patient& p, F&& f) {
+        f(TermField::Disease, p.getDisease(), p.diseaseSymbol());
+        if (p.type() == PatientType::Elder) {
+            const auto& elder = static_cast<const ElderPatient&>(p);
+            f(TermField::Allergies, elder.getAllergies(), elder.allergiesSymbol());
+            f(TermField::Contraindications, elder.getContraindications(), elder.contraindicationsSymbol());
+        }
+    }
+
+    const std::string& keyOf(TermField field, std::string_view word) {
+        key.assign(1, static_cast<char>(field));
+        key.append(word);
+        return key;
+    }
+
+    // Лише для словника, яким індекс уже володіє сам (див. wordLists)
+    std::uint32_t listFor(TermField field, std::string_view word) {
+        const auto it = vocabulary->termIds.try_emplace(keyOf(field, word), static_cast<std::uint32_t>(lists.size())).first;
+        if (it->second == lists.size()) lists.push_back(std::make_shared<PostingList>());
+        return it->second;
+    }
+
+    // Спільний з копіями словник — перед зміною відокремлюється (кеш останнього пулу вказував у старий)
+    Vocabulary& ownVocabulary() {
+        if (vocabulary.use_count() > 1) {
+            vocabulary = std::make_shared<Vocabulary>(*vocabulary);
+            lastPool = nullptr;
+        }
+        return *vocabulary;
+    }
+
+    // Кеш пулу без змін словника (nullptr — тексти цього пулу ще не розбиралися)
+    const PoolCache* findCache(const SymbolPool& pool) {
+        if (&pool != lastPool) {
+            const auto it = vocabulary->caches.find(&pool);
+            if (it == vocabulary->caches.end()) return nullptr;
+            lastCache = &it->second;
+            lastPool = &pool;
+        }
+        return lastCache;
+    }
+
+    // Номери списків для слів тексту text із номером symbol (розбирається при першому зверненні;
+    // слова, яких ще немає в індексі, отримують порожні списки). Спільний словник відокремлюється
+    // лише тоді, коли текст справді треба розібрати
+    const std::uint32_t* wordLists(const SymbolPool& pool, TermField field, SymbolPool::Id symbol, std::string_view text) {
+        if (const PoolCache* known = findCache(pool)) {
+            const auto& start = known->start[static_cast<std::size_t>(field)];
+            if (symbol < start.size() && start[symbol] != kNotParsed) return known->data.data() + start[symbol];
+        }
+        ownVocabulary();
+        if (&pool != lastPool) {
+            lastCache = &vocabulary->caches[&pool];
+            lastPool = &pool;
+        }
+        PoolCache& cache = *lastCache;
+        auto& start = cache.start[static_cast<std::size_t>(field)];
+        if (start.size() <= symbol) start.resize(static_cast<std::size_t>(symbol) + 1, kNotParsed);
+        const auto offset = static_cast<std::uint32_t>(cache.data.size());
+        cache.data.push_back(0);
+        forEachTerm(text, term, [&](std::string_view word) {
+            const std::uint32_t list = listFor(field, word);
+            cache.data.push_back(list);
+            ++cache.data[offset];
+        });
+        start[symbol] = offset;
+        return cache.data.data() + offset;
+    }
+
+public:
+    void insert(std::uint32_t slot, const Patient& p) {
+        forEachField(p, [&](TermField field, std::string_view text, SymbolPool::Id symbol) {
+            const std::uint32_t* words = wordLists(p.symbolPool(), field, symbol, text);
+            for (std::uint32_t i = 1; i <= words[0]; ++i) detach(lists[words[i]]).insert(slot);
+        });
+    }
+
+    // Заміна вмісту count записами; entryAt(i) — пара (слот, const Patient*) i-го. Слоти
+    // спершу збираються у звичайні вектори, потім кожен список кодується один раз (assign)
+    template <class EntryAt>
+    void build(std::size_t count, EntryAt&& entryAt) {
+        clear();
+        std::vector<std::vector<std::uint32_t>> slots;
+        for (std::size_t i = 0; i < count; ++i) {
+            const auto [slot, p] = entryAt(i);
+            forEachField(*p, [&](TermField field, std::string_view text, SymbolPool::Id symbol) {
+                const std::uint32_t* words = wordLists(p->symbolPool(), field, symbol, text);
+                if (slots.size() < lists.size()) slots.resize(lists.size());
+                for (std::uint32_t k = 1; k <= words[0]; ++k) slots[words[k]].push_back(slot);
+            });
+        }
+        for (std::size_t k = 0; k < slots.size(); ++k) {
+            auto& sorted = slots[k];
+            if (!std::is_sorted(sorted.begin(), sorted.end())) std::sort(sorted.begin(), sorted.end());
+            sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end()); // слово двічі в полі
+            lists[k]->assign(sorted);
+        }
+    }
+
+    void erase(std::uint32_t slot, const Patient& p) {
+        forEachField(p, [&](TermField field, std::string_view text, SymbolPool::Id symbol) {
+            const std::uint32_t* words = wordLists(p.symbolPool(), field, symbol, text);
+            for (std::uint32_t i = 1; i <= words[0]; ++i) detach(lists[words[i]]).erase(slot);
+        });
+    }
+
+    // Записи other зі слотами, зсунутими на slotOffset (див. SlotMap::append): список кожного
+    // терма other дописується блоками до списку того самого терма, тексти не розбираються.
+    // Розібрані тексти пулів other не переносяться — вони розберуться при першому видаленні
+    void append(const TermIndex& other, std::uint32_t slotOffset) {
+        for (const auto& [termKey, list] : other.vocabulary->termIds) {
+            if (other.lists[list]->empty()) continue;
+            const auto it = ownVocabulary().termIds.try_emplace(termKey, static_cast<std::uint32_t>(lists.size())).first;
+            if (it->second == lists.size()) lists.push_back(std::make_shared<PostingList>());
+            detach(lists[it->second]).append(*other.lists[list], slotOffset);
+        }
+    }
+
+    // Списки для всіх слів умови (nullptr — слова немає в жодного пацієнта); порожній —
+    // умова без жодного слова
+    std::vector<const PostingList*> listsFor(const TermClause& clause) const {
+        std::vector<const PostingList*> found;
+        std::string lookup;
+        std::string word;
+        forEachTerm(clause.text, word, [&](std::string_view w) {
+            lookup.assign(1, static_cast<char>(clause.field));
+            lookup.append(w);
+            const auto it = vocabulary->termIds.find(lookup);
+            found.push_back(it == vocabulary->termIds.end() ? nullptr : lists[it->second].get());
+        });
+        return found;
+    }
+
+    void clear() {
+        vocabulary = std::make_shared<Vocabulary>();
+        lists.clear();
+        lastPool = nullptr;
+        lastCache = nullptr;
+    }
+
+    // Копія ділить словник і списки; вказівник на кеш оригіналу не переноситься
+    TermIndex() = default;
+    TermIndex(const TermIndex& other) : vocabulary(other.vocabulary), lists(other.lists) {}
+    TermIndex& operator=(const TermIndex& other) {
+        vocabulary = other.vocabulary;
+        lists = other.lists;
+        lastPool = nullptr;
+        lastCache = nullptr;
+        return *this;
+    }
+};
+
+// ===========================
+// Ключ для пошуку за початком імені: нижній регістр, варіанти літер зведені до основних
+// (є→е, ї→і, й→и, ґ→г, ё→е), апострофи відкинуто, слова розділені одним пробілом.
+// «Олексій», «ОЛЕКСИЙ» і «олексій» дають один ключ. trailingGap зберігає пробіл у кінці
+// (запит «Іван » не повинен знаходити «Іваненко»)
+// ===========================
+inline char32_t foldNameCodepoint(char32_t cp) {
+    cp = lowerCodepoint(cp);
+    switch (cp) {
+    case 0x454: return 0x435; // є → е
+    case 0x451: return 0x435; // ё → е
+    case 0x457: return 0x456; // ї → і
+    case 0x439: return 0x438; // й → и
+    case 0x491: return 0x433; // ґ → г
+    default: return cp;
+    }
+}
+
+inline void foldName(std::string_view text, std::string& out, bool trailingGap = false) {
+    out.clear();
+    bool gap = false;
+    std::size_t i = 0;
+    while (i < text.size()) {
+        const char32_t cp = decodeUtf8(text, i);
+        if (isApostrophe(cp)) continue;
+        if (!isWordCodepoint(cp)) {
+            gap = !out.empty();
+            continue;
+        }
+        if (gap) out += ' ';
+        gap = false;
+        appendUtf8(out, foldNameCodepoint(cp));
+    }
+    if (gap && trailingGap) out += ' ';
+}
+
+// ===========================
+// NamePrefixIndex: відсортований словник пар (foldName(ім'я), номер слота SlotMap) для підказок
+// за початком імені. Пари лежать блоками до kMaxBlock записів, ключі в блоці стиснуті
+// фронтальним кодуванням (довжина спільного з попереднім префікса + решта), тож повторювані
+// прізвища займають кілька байтів. Блоки впорядковані за першою парою в std::map: підказка —
+// O(log блоків) і розкодування одного-двох блоків. Нові пари спершу лягають у невелику
+// відсортовану дельту без стиснення; коли вона заповнюється, пари вливаються в блоки разом,
+// і кожен зачеплений блок перекодовується один раз на злиття, а не на кожну вставку.
+// Видалення перекодовує один блок. Повна побудова (build) — одне сортування всіх пар і запис блоків підряд
+// ===========================
+class NamePrefixIndex {
+public:
+    static constexpr std::size_t kMaxBlock = 64;
+    static constexpr std::size_t kMaxDelta = 256; // пар у дельті до злиття з блоками
+
+private:
+    struct Key {
+        std::string name;
+        std::uint32_t slot;
+
+        bool operator<(const Key& other) const {
+            const int order = name.compare(other.name);
+            return order != 0 ? order < 0 : slot < other.slot;
+        }
+    };
+
+    struct Block {
+        std::uint32_t count = 0;
+        std::vector<unsigned char> bytes; // на запис: спільний префікс, довжина решти, решта, слот (varint)
+    };
+
+    struct Entry {
+        std::uint32_t offset; // у keys
+        std::uint32_t length;
+        std::uint32_t slot;
+    };
+
+    using BlockMap = std::map<Key, std::shared_ptr<const Block>>;
+
+    BlockMap blocks;             // ключ — перша пара блоку; блоки незмінні, копія індексу ділить їх
+    std::vector<Key> delta;      // відсортовані пари, ще не влиті в блоки
+    std::size_t total = 0;
+    std::string folded;          // буфери розкодованого блоку, перевикористовуються
+    std::string scratch;
+    std::string keys;
+    std::vector<Entry> entries;
+
+    // f(std::string_view ключ, std::uint32_t слот) для пар блоку по порядку; false — зупинитися
+    template <class F>
+    static bool forEachIn(const Block& block, std::string& key, F&& f) {
+        const unsigned char* p = block.bytes.data();
+        key.clear();
+        for (std::uint32_t i = 0; i < block.count; ++i) {
+            key.resize(readVarint(p));
+            const std::uint32_t rest = readVarint(p);
+            key.append(reinterpret_cast<const char*>(p), rest);
+            p += rest;
+            const std::uint32_t slot = readVarint(p);
+            if (!f(std::string_view(key), slot)) return false;
+        }
+        return true;
+    }
+
+    void decode(const Block& block) {
+        keys.clear();
+        entries.clear();
+        forEachIn(block, scratch, [&](std::string_view key, std::uint32_t slot) {
+            entries.push_back({ static_cast<std::uint32_t>(keys.size()), static_cast<std::uint32_t>(key.size()), slot });
+            keys.append(key);
+            return true;
+        });
+    }
+
+    std::string_view keyAt(std::size_t i) const {
+        return std::string_view(keys).substr(entries[i].offset, entries[i].length);
+    }
+
+    void encode(Block& block, std::size_t from, std::size_t to) const {
+        block.count = static_cast<std::uint32_t>(to - from);
+        block.bytes.clear();
+        std::string_view prev;
+        for (std::size_t i = from; i < to; ++i) {
+            const std::string_view key = keyAt(i);
+            const std::size_t limit = std::min(prev.size(), key.size());
+            std::size_t shared = 0;
+            while (shared < limit && prev[shared] == key[shared]) ++shared;
+            putVarint(block.bytes, static_cast<std::uint32_t>(shared));
+            putVarint(block.bytes, static_cast<std::uint32_t>(key.size() - shared));
+            block.bytes.insert(block.bytes.end(), key.begin() + static_cast<std::ptrdiff_t>(shared), key.end());
+            putVarint(block.bytes, entries[i].slot);
+            prev = key;
+        }
+    }
+
+    // Блок, куди належить пара (останній, що починається не пізніше; інакше — перший)
+    BlockMap::iterator blockFor(const Key& key) {
+        auto it = blocks.upper_bound(key);
+        return it == blocks.begin() ? it : std::prev(it);
+    }
+
+    // Перша пара блоку змінилась — вузол переставляється з новим ключем
+    BlockMap::iterator rekey(BlockMap::iterator it) {
+        auto node = blocks.extract(it);
+        node.key() = Key{ std::string(keyAt(0)), entries[0].slot };
+        return blocks.insert(std::move(node)).position;
+    }
+
+    bool less(std::size_t i, const Key& key) const {
+        const int order = keyAt(i).compare(key.name);
+        return order != 0 ? order < 0 : entries[i].slot < key.slot;
+    }
+
+    bool entryLess(const Entry& a, const Entry& b) const {
+        const int order = std::string_view(keys).substr(a.offset, a.length).compare(std::string_view(keys).substr(b.offset, b.length));
+        return order != 0 ? order < 0 : a.slot < b.slot;
+    }
+
+    // Розкодовані пари (entries, відсортовані) записуються рівними блоками не більше kMaxBlock
+    // на місце блоку it (blocks.end() — лише нові блоки)
+    void store(BlockMap::iterator it) {
+        const std::size_t parts = (entries.size() + kMaxBlock - 1) / kMaxBlock;
+        for (std::size_t part = 0; part < parts; ++part) {
+            const std::size_t from = entries.size() * part / parts;
+            auto block = std::make_shared<Block>();
+            encode(*block, from, entries.size() * (part + 1) / parts);
+            if (part == 0 && it != blocks.end()) {
+                it->second = std::move(block);
+                if (it->first.slot != entries[0].slot || it->first.name != keyAt(0)) it = rekey(it);
+                continue;
+            }
+            it = blocks.emplace_hint(it == blocks.end() ? it : std::next(it),
+                Key{ std::string(keyAt(from)), entries[from].slot }, std::move(block));
+        }
+    }
+
+    // Дельта вливається в блоки: пари, що належать одному блоку, додаються до нього разом
+    void mergeDelta() {
+        std::size_t i = 0;
+        while (i < delta.size()) {
+            auto it = blocks.empty() ? blocks.end() : blockFor(delta[i]);
+            std::size_t end = delta.size();
+            if (it != blocks.end()) {
+                const auto next = std::next(it);
+                end = i;
+                while (end < delta.size() && (next == blocks.end() || delta[end] < next->first)) ++end;
+                decode(*it->second);
+            }
+            else {
+                keys.clear();
+                entries.clear();
+            }
+            const std::size_t existing = entries.size();
+            for (std::size_t d = i; d < end; ++d) {
+                entries.push_back({ static_cast<std::uint32_t>(keys.size()), static_cast<std::uint32_t>(delta[d].name.size()), delta[d].slot });
+                keys += delta[d].name;
+            }
+            std::inplace_merge(entries.begin(), entries.begin() + static_cast<std::ptrdiff_t>(existing), entries.end(),
+                [&](const Entry& a, const Entry& b) { return entryLess(a, b); });
+            store(it);
+            i = end;
+        }
+        delta.clear();
+    }
+
+public:
+    void insert(std::uint32_t slot, std::string_view name) {
+        foldName(name, folded);
+        Key key{ folded, slot };
+        delta.insert(std::upper_bound(delta.begin(), delta.end(), key), std::move(key));
+        ++total;
+        if (delta.size() >= kMaxDelta) mergeDelta();
+    }
+
+    // Замінює вміст індексу парами (слот, ім'я) у будь-якому порядку: імена згортаються в один
+    // буфер, пари сортуються один раз, блоки заповнюються до kMaxBlock і додаються в кінець map
+    void build(const std::vector<std::pair<std::uint32_t, std::string_view>>& names) {
+        clear();
+        keys.clear();
+        entries.clear();
+        entries.reserve(names.size());
+        for (const auto& [slot, name] : names) {
+            foldName(name, folded);
+            entries.push_back({ static_cast<std::uint32_t>(keys.size()), static_cast<std::uint32_t>(folded.size()), slot });
+            keys += folded;
+        }
+        std::sort(entries.begin(), entries.end(), [&](const Entry& a, const Entry& b) { return entryLess(a, b); });
+        for (std::size_t from = 0; from < entries.size(); from += kMaxBlock) {
+            auto block = std::make_shared<Block>();
+            encode(*block, from, std::min(from + kMaxBlock, entries.size()));
+            blocks.emplace_hint(blocks.end(), Key{ std::string(keyAt(from)), entries[from].slot }, std::move(block));
+        }
+        total = entries.size();
+    }
+
+    // name — ім'я, з яким slot додано
+    void erase(std::uint32_t slot, std::string_view name) {
+        foldName(name, folded);
+        const Key key{ folded, slot };
+        const auto pending = std::lower_bound(delta.begin(), delta.end(), key);
+        if (pending != delta.end() && pending->slot == slot && pending->name == folded) {
+            delta.erase(pending);
+            --total;
+            return;
+        }
+        if (blocks.empty()) return;
+        auto it = blockFor(key);
+        decode(*it->second);
+        std::size_t pos = 0;
+        while (pos < entries.size() && less(pos, key)) ++pos;
+        if (pos == entries.size() || entries[pos].slot != slot || keyAt(pos) != folded) return;
+        entries.erase(entries.begin() + static_cast<std::ptrdiff_t>(pos));
+        --total;
+        if (entries.empty()) {
+            blocks.erase(it);
+            return;
+        }
+        auto block = std::make_shared<Block>();
+        encode(*block, 0, entries.size());
+        it->second = std::move(block);
+        if (pos == 0) rekey(it);
+    }
+
+    // f(std::uint32_t слот) для перших limit імен, що починаються з prefix (після foldName),
+    // за алфавітом згорнутих імен. Повертає кількість знайдених
+    template <class F>
+    std::size_t forEachWithPrefix(std::string_view prefix, std::size_t limit, F&& f) const {
+        if (limit == 0) return 0;
+        Key start{ std::string(), 0 };
+        foldName(prefix, start.name, true);
+        auto it = blocks.upper_bound(start);
+        if (it != blocks.begin()) --it;
+        const std::string_view wanted = start.name;
+        const auto matches = [&](std::string_view name) { return name.substr(0, wanted.size()) == wanted; };
+        auto pending = std::lower_bound(delta.begin(), delta.end(), start); // пари дельти зливаються з блоковими
+        std::string key;
+        std::size_t found = 0;
+        for (; it != blocks.end() && found < limit; ++it) {
+            const bool more = forEachIn(*it->second, key, [&](std::string_view name, std::uint32_t slot) {
+                if (name < wanted) return true;
+                if (!matches(name)) return false;
+                for (; pending != delta.end() && found < limit && matches(pending->name); ++pending) {
+                    const int order = std::string_view(pending->name).compare(name);
+                    if (order > 0 || (order == 0 && pending->slot > slot)) break;
+                    f(pending->slot);
+                    ++found;
+                }
+                if (found == limit) return false;
+                f(slot);
+                return ++found < limit;
+            });
+            if (!more) break;
+        }
+        for (; pending != delta.end() && found < limit && matches(pending->name); ++pending) {
+            f(pending->slot);
+            ++found;
+        }
+        return found;
+    }
+
+    std::size_t size() const { return total; }
+
+    void clear() {
+        blocks.clear();
+        delta.clear();
+        total = 0;
+    }
+};
+
+// UTF-8 → кодові точки (для посимвольного порівняння імен)
+inline void toCodepoints(std::string_view text, std::u32string& out) {
+    out.clear();
+    for (std::size_t i = 0; i < text.size();) out += decodeUtf8(text, i);
+}
+
+// Відстань Левенштейна між a і b, якщо вона не більша за limit, інакше limit + 1.
+// Рахується лише смуга шириною 2·limit + 1 навколо діагоналі — O(|a|·limit)
+inline int boundedEditDistance(const std::u32string& a, const std::u32string& b, int limit) {
+    const int n = static_cast<int>(a.size());
+    const int m = static_cast<int>(b.size());
+    if ((n > m ? n - m : m - n) > limit) return limit + 1;
+    const int over = limit + 1;
+    std::vector<int> prev(static_cast<std::size_t>(m) + 1, over);
+    std::vector<int> cur(static_cast<std::size_t>(m) + 1, over);
+    for (int j = 0; j <= std::min(m, limit); ++j) prev[j] = j;
+    for (int i = 1; i <= n; ++i) {
+        const int lo = std::max(1, i - limit);
+        const int hi = std::min(m, i + limit);
+        std::fill(cur.begin(), cur.end(), over);
+        if (i <= limit) cur[0] = i;
+        int best = cur[0];
+        for (int j = lo; j <= hi; ++j) {
+            const int substitute = prev[j - 1] + (a[i - 1] == b[j - 1] ? 0 : 1);
+            cur[j] = std::min({ substitute, prev[j] + 1, cur[j - 1] + 1, over });
+            best = std::min(best, cur[j]);
+        }
+        if (best > limit) return over; // уся смуга вже за межею
+        std::swap(prev, cur);
+    }
+    return prev[m];
+}
+
+// ===========================
+// TrigramIndex: триграми згорнутих імен (foldName, із межовим символом з обох боків) →
+// PostingList номерів слотів SlotMap, плюс довжина кожного імені в символах.
+// Кожна правка зачіпає не більше трьох триграм, тож ім'я на відстані ≤ k від запиту з q
+// різними триграмами має щонайменше q − 3k спільних. Кандидатів дають лише q − T + 1
+// найкоротших списків (T — поріг), решта списків лише перевіряє їх перескоком курсора —
+// довгі списки поширених триграм не обходяться повністю. Рядки індекс не зберігає
+// ===========================
+class TrigramIndex {
+private:
+    static constexpr char32_t kBoundary = 1;
+
+    std::unordered_map<std::uint64_t, std::uint32_t> gramIds;
+    std::vector<std::shared_ptr<PostingList>> lists; // копія ділить списки; зміна відокремлює свій
+    SegmentedVector<std::uint32_t> lengths; // за номером слота: довжина згорнутого імені в символах
+    std::string folded;                     // буфери, перевикористовуються
+    std::u32string padded;
+    std::vector<std::uint64_t> grams;
+
+    // Різні триграми name (відсортовані) у grams; повертає довжину згорнутого імені
+    static std::size_t gramsOf(std::string_view name, std::string& folded, std::u32string& padded,
+        std::vector<std::uint64_t>& grams) {
+        foldName(name, folded);
+        padded.assign(1, kBoundary);
+        for (std::size_t i = 0; i < folded.size();) padded += decodeUtf8(folded, i);
+        padded += kBoundary;
+        grams.clear();
+        for (std::size_t i = 0; i + 3 <= padded.size(); ++i) {
+            grams.push_back((static_cast<std::uint64_t>(padded[i]) << 42) |
+                (static_cast<std::uint64_t>(padded[i + 1]) << 21) | padded[i + 2]);
+        }
+        std::sort(grams.begin(), grams.end());
+        grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+        return padded.size() - 2;
+    }
+
+public:
+    void insert(std::uint32_t slot, std::string_view name) {
+        const std::size_t length = gramsOf(name, folded, padded, grams);
+        while (lengths.size() <= slot) lengths.push_back(0);
+        lengths[slot] = static_cast<std::uint32_t>(length);
+        for (const std::uint64_t gram : grams) {
+            const auto it = gramIds.try_emplace(gram, static_cast<std::uint32_t>(lists.size())).first;
+            if (it->second == lists.size()) lists.push_back(std::make_shared<PostingList>());
+            detach(lists[it->second]).insert(slot);
+        }
+    }
+
+    // Замінює вміст індексу парами (слот, ім'я) у будь-якому порядку: пари обходяться за
+    // зростанням слота, тож список кожної триграми збирається вже відсортованим і кодується
+    // один раз повними блоками (PostingList::assign)
+    void build(std::vector<std::pair<std::uint32_t, std::string_view>> names) {
+        clear();
+        std::sort(names.begin(), names.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        std::vector<std::vector<std::uint32_t>> pending;
+        for (const auto& [slot, name] : names) {
+            const std::size_t length = gramsOf(name, folded, padded, grams);
+            while (lengths.size() <= slot) lengths.push_back(0);
+            lengths[slot] = static_cast<std::uint32_t>(length);
+            for (const std::uint64_t gram : grams) {
+                const auto it = gramIds.try_emplace(gram, static_cast<std::uint32_t>(pending.size())).first;
+                if (it->second == pending.size()) pending.emplace_back();
+                pending[it->second].push_back(slot);
+            }
+        }
+        lists.resize(pending.size());
+        for (std::size_t i = 0; i < pending.size(); ++i) {
+            lists[i] = std::make_shared<PostingList>();
+            lists[i]->assign(pending[i]);
+        }
+    }
+
+    // name — ім'я, з яким slot додано
+    void erase(std::uint32_t slot, std::string_view name) {
+        gramsOf(name, folded, padded, grams);
+        for (const std::uint64_t gram : grams) {
+            const auto it = gramIds.find(gram);
+            if (it != gramIds.end()) detach(lists[it->second]).erase(slot);
+        }
+    }
+
+    // f(std::uint32_t слот, std::size_t спільних триграм) для кожного імені, яке може бути на
+    // відстані ≤ maxDistance від name: не менше T спільних триграм і різниця довжин ≤ maxDistance.
+    // Короткі запити (q − 3k < 1) вимагають хоча б однієї спільної триграми. Слоти — за зростанням
+    template <class F>
+    void forEachCandidate(std::string_view name, int maxDistance, F&& f) const {
+        std::string queryFolded;
+        std::u32string queryPadded;
+        std::vector<std::uint64_t> queryGrams;
+        const std::size_t length = gramsOf(name, queryFolded, queryPadded, queryGrams);
+        const std::ptrdiff_t lost = 3 * static_cast<std::ptrdiff_t>(std::max(maxDistance, 0));
+        const std::size_t threshold = static_cast<std::size_t>(
+            std::max<std::ptrdiff_t>(1, static_cast<std::ptrdiff_t>(queryGrams.size()) - lost));
+
+        std::vector<const PostingList*> found;
+        for (const std::uint64_t gram : queryGrams) {
+            const auto it = gramIds.find(gram);
+            if (it != gramIds.end() && !lists[it->second]->empty()) found.push_back(lists[it->second].get());
+        }
+        if (found.size() < threshold) return;
+        std::sort(found.begin(), found.end(), [](const PostingList* a, const PostingList* b) { return a->size() < b->size(); });
+
+        const std::size_t generators = found.size() - threshold + 1;
+        std::vector<std::uint32_t> slots;
+        for (std::size_t k = 0; k < generators; ++k) {
+            for (PostingList::Cursor c(*found[k]); c.valid(); c.next()) slots.push_back(c.value());
+        }
+        std::sort(slots.begin(), slots.end());
+
+        std::vector<PostingList::Cursor> checks;
+        for (std::size_t k = generators; k < found.size(); ++k) checks.emplace_back(*found[k]);
+        for (std::size_t i = 0; i < slots.size();) {
+            const std::uint32_t slot = slots[i];
+            std::size_t hits = 0;
+            for (; i < slots.size() && slots[i] == slot; ++i) ++hits;
+            for (auto& c : checks) {
+                c.advanceTo(slot);
+                hits += c.valid() && c.value() == slot ? 1 : 0;
+            }
+            const std::size_t other = lengths[slot];
+            const std::size_t gap = other > length ? other - length : length - other;
+            if (hits >= threshold && gap <= static_cast<std::size_t>(std::max(maxDistance, 0))) f(slot, hits);
+        }
+    }
+
+    void clear() {
+        gramIds.clear();
+        lists.clear();
+        lengths.clear();
+    }
+};
+
+// ===========================
+// Аналітика без віртуальних викликів: вік і тип кожного запису продубльовані в щільних
+// колонках за номером слота SlotMap (вільний слот — тип kVacant). Ядра обробляють групи
+// по 32 слоти: AVX2 — тип через таблицю _mm256_shuffle_epi8 (kVacant має старший біт і дає 0),
+// вік — одним беззнаковим порівнянням (age − minAge) ≤ span; скалярний варіант — для інших
+// процесорів. Як і пошук роздільників, реалізація обирається один раз за CPUID
+// ===========================
+struct ColumnScan {
+    std::uint8_t typeMask;  // біт t — PatientType t проходить
+    std::int32_t minAge;
+    std::uint32_t ageSpan;  // вік проходить, якщо (age − minAge) як unsigned ≤ ageSpan
+};
+
+constexpr std::size_t kColumnGroup = 32;
+
+// masks[g] — біт i: слот g·32 + i проходить; повертає суму віку слотів, що пройшли (якщо withSum)
+using ColumnKernelFn = std::int64_t(*)(const std::int32_t* ages, const std::uint8_t* tags, std::size_t groups,
+    const ColumnScan& scan, std::uint32_t* masks, bool withSum);
+
+inline std::int64_t scanColumnsScalar(const std::int32_t* ages, const std::uint8_t* tags, std::size_t groups,
+    const ColumnScan& scan, std::uint32_t* masks, bool withSum) {
+    std::int64_t sum = 0;
+    for (std::size_t g = 0; g < groups; ++g) {
+        std::uint32_t mask = 0;
+        for (std::size_t i = 0; i < kColumnGroup; ++i) {
+            const std::size_t at = g * kColumnGroup + i;
+            const bool typeOk = tags[at] < 8 && ((scan.typeMask >> tags[at]) & 1) != 0;
+            const bool ageOk = static_cast<std::uint32_t>(ages[at]) - static_cast<std::uint32_t>(scan.minAge) <= scan.ageSpan;
+            if (typeOk && ageOk) {
+                mask |= std::uint32_t{ 1 } << i;
+                if (withSum) sum += ages[at];
+            }
+        }
+        masks[g] = mask;
+    }
+    return sum;
+}
+
+#ifdef POLYCLINIC_X86
+POLYCLINIC_TARGET("avx2") inline std::int64_t scanColumnsAvx2(const std::int32_t* ages, const std::uint8_t* tags,
+    std::size_t groups, const ColumnScan& scan, std::uint32_t* masks, bool withSum) {
+    alignas(16) std::uint8_t lut[16] = {};
+    for (unsigned t = 0; t < 8; ++t) lut[t] = ((scan.typeMask >> t) & 1) ? 0xFF : 0;
+    const __m256i typeLut = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(lut)));
+    const __m256i sign = _mm256_set1_epi32(static_cast<int>(0x80000000u));
+    const __m256i minAge = _mm256_set1_epi32(scan.minAge);
+    const __m256i bound = _mm256_xor_si256(_mm256_set1_epi32(static_cast<int>(scan.ageSpan)), sign);
+    __m256i sum = _mm256_setzero_si256(); // 4 × int64
+    for (std::size_t g = 0; g < groups; ++g) {
+        const __m256i t = _mm256_load_si256(reinterpret_cast<const __m256i*>(tags + g * kColumnGroup));
+        const auto typeBits = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_shuffle_epi8(typeLut, t)));
+        std::uint32_t ageBits = 0;
+        for (int k = 0; k < 4; ++k) {
+            const __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(ages + g * kColumnGroup + 8 * k));
+            const __m256i shifted = _mm256_xor_si256(_mm256_sub_epi32(a, minAge), sign);
+            const __m256i outside = _mm256_cmpgt_epi32(shifted, bound); // знакове порівняння зі зсувом = беззнакове
+            ageBits |= static_cast<std::uint32_t>(~_mm256_movemask_ps(_mm256_castsi256_ps(outside)) & 0xFF) << (8 * k);
+            if (withSum) {
+                const std::uint32_t lanes = (typeBits >> (8 * k)) & 0xFF;
+                const __m256i laneBits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+                const __m256i typeOk = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(static_cast<int>(lanes)), laneBits), laneBits);
+                const __m256i kept = _mm256_andnot_si256(outside, _mm256_and_si256(a, typeOk));
+                sum = _mm256_add_epi64(sum, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(kept)));
+                sum = _mm256_add_epi64(sum, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(kept, 1)));
+            }
+        }
+        masks[g] = typeBits & ageBits;
+    }
+    alignas(32) std::int64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), sum);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+#endif // POLYCLINIC_X86
+
+inline ColumnKernelFn selectColumnKernel() {
+#ifdef POLYCLINIC_X86
+    if (cpuHasAvx2()) return scanColumnsAvx2;
+#endif
+    return scanColumnsScalar;
+}
+
+inline ColumnKernelFn activeColumnKernel() {
+    static const ColumnKernelFn fn = selectColumnKernel();
+    return fn;
+}
+
+// Умова для PatientColumns (Polyclinic::count / sumAges / histogram / filter, ColumnarPatientStore): типи пацієнтів і вік від minAge до maxAge
+struct ColumnFilter {
+    static constexpr std::uint8_t kAllTypes = 0x7;
+
+    std::uint8_t types = kAllTypes; // біт static_cast<int>(PatientType)
+    int minAge = std::numeric_limits<int>::min();
+    int maxAge = std::numeric_limits<int>::max();
+
+    static ColumnFilter of(PatientType type) { return { static_cast<std::uint8_t>(1u << static_cast<unsigned>(type)) }; }
+    ColumnFilter& ages(int lo, int hi) {
+        minAge = lo;
+        maxAge = hi;
+        return *this;
+    }
+};
+
+// ===========================
+// PatientColumns: колонки віку й типу за номером слота, сторінками по kPage слотів
+// (вирівняні на 32 байти, вставка не переносить уже записані сторінки). Вільні слоти й
+// хвіст останньої сторінки мають тип kVacant, тож ядра не потребують окремої перевірки меж.
+// Спільний аналітичний шар для Polyclinic (слоти SlotMap) і ColumnarPatientStore (рядки 0..n-1)
+// ===========================
+class PatientColumns {
+public:
+    static constexpr std::size_t kPage = 4096;
+    static constexpr std::uint8_t kVacant = 0xFF;
+
+private:
+    struct Page {
+        alignas(32) std::int32_t ages[kPage];
+        alignas(32) std::uint8_t tags[kPage];
+    };
+
+    std::vector<std::shared_ptr<Page>> pages; // копія ділить сторінки; зміна відокремлює свою (detach)
+    std::size_t extent = 0; // слоти [0, extent) можуть бути зайняті
+
+    static std::shared_ptr<Page> vacantPage() {
+        auto page = std::make_shared<Page>();
+        std::fill(std::begin(page->tags), std::end(page->tags), kVacant);
+        return page;
+    }
+
+    // Скільки груп по 32 слоти сторінки p лежить у [0, extent)
+    std::size_t groupsIn(std::size_t p) const {
+        const std::size_t slots = std::min(kPage, extent - p * kPage);
+        return (slots + kColumnGroup - 1) / kColumnGroup;
+    }
+
+    // f(std::uint32_t першийСлот, const std::uint32_t* masks, std::size_t groups) для кожної сторінки;
+    // повертає суму віку слотів, що пройшли (якщо withSum)
+    template <class F>
+    std::int64_t scan(const ColumnFilter& where, bool withSum, F&& f) const {
+        if (where.minAge > where.maxAge || where.types == 0) return 0;
+        const ColumnScan query{ where.types, where.minAge,
+            static_cast<std::uint32_t>(where.maxAge) - static_cast<std::uint32_t>(where.minAge) };
+        const ColumnKernelFn kernel = activeColumnKernel();
+        std::uint32_t masks[kPage / kColumnGroup];
+        std::int64_t sum = 0;
+        for (std::size_t p = 0; p * kPage < extent; ++p) {
+            const std::size_t groups = groupsIn(p);
+            sum += kernel(pages[p]->ages, pages[p]->tags, groups, query, masks, withSum);
+            f(static_cast<std::uint32_t>(p * kPage), masks, groups);
+        }
+        return sum;
+    }
+
+public:
+    void insert(std::uint32_t slot, PatientType type, int age) {
+        while (pages.size() * kPage <= slot) pages.push_back(vacantPage());
+        Page& page = detach(pages[slot / kPage]);
+        page.ages[slot % kPage] = age;
+        page.tags[slot % kPage] = static_cast<std::uint8_t>(type);
+        extent = std::max(extent, static_cast<std::size_t>(slot) + 1);
+    }
+
+    // Заміна вмісту count записами; entryAt(i) — пара (слот, const Patient*) i-го. Сторінки
+    // виділяються одразу під найбільший слот, старі не зберігаються (clear звільняє їх)
+    template <class EntryAt>
+    void build(std::size_t count, EntryAt&& entryAt) {
+        clear();
+        std::size_t maxSlot = 0;
+        for (std::size_t i = 0; i < count; ++i) maxSlot = std::max<std::size_t>(maxSlot, entryAt(i).first);
+        if (count == 0) return;
+        pages.resize(maxSlot / kPage + 1);
+        for (auto& page : pages) page = vacantPage();
+        for (std::size_t i = 0; i < count; ++i) {
+            const auto [slot, p] = entryAt(i);
+            Page& page = *pages[slot / kPage];
+            page.ages[slot % kPage] = p->getAge();
+            page.tags[slot % kPage] = static_cast<std::uint8_t>(p->type());
+        }
+        extent = maxSlot + 1;
+    }
+
+    // Зайняті слоти other зі зсувом slotOffset (див. SlotMap::append)
+    void append(const PatientColumns& other, std::uint32_t slotOffset) {
+        for (std::uint32_t slot = 0; slot < other.extent; ++slot) {
+            if (other.typeAt(slot) != static_cast<PatientType>(kVacant))
+                insert(slotOffset + slot, other.typeAt(slot), other.ageAt(slot));
+        }
+    }
+
+    void erase(std::uint32_t slot) { detach(pages[slot / kPage]).tags[slot % kPage] = kVacant; }
+
+    int ageAt(std::uint32_t slot) const { return pages[slot / kPage]->ages[slot % kPage]; }
+    PatientType typeAt(std::uint32_t slot) const { return static_cast<PatientType>(pages[slot / kPage]->tags[slot % kPage]); }
+
+    // Кількість зайнятих слотів, що проходять where
+    std::size_t count(const ColumnFilter& where) const {
+        std::size_t total = 0;
+        scan(where, false, [&](std::uint32_t, const std::uint32_t* masks, std::size_t groups) {
+            for (std::size_t g = 0; g < groups; ++g) total += popcount64(masks[g]);
+        });
+        return total;
+    }
+
+    std::int64_t sumAges(const ColumnFilter& where) const {
+        return scan(where, true, [](std::uint32_t, const std::uint32_t*, std::size_t) {});
+    }
+
+    // Кількість за кожним PatientType
+    std::array<std::size_t, 3> histogram(const ColumnFilter& where) const {
+        std::array<std::size_t, 3> byType{};
+        for (std::size_t t = 0; t < byType.size(); ++t) {
+            ColumnFilter one = where;
+            one.types &= static_cast<std::uint8_t>(1u << t);
+            if (one.types != 0) byType[t] = count(one);
+        }
+        return byType;
+    }
+
+    // f(std::uint32_t слот) для кожного слота, що проходить where, за зростанням
+    template <class F>
+    void forEachMatch(const ColumnFilter& where, F&& f) const {
+        scan(where, false, [&](std::uint32_t first, const std::uint32_t* masks, std::size_t groups) {
+            for (std::size_t g = 0; g < groups; ++g) {
+                for (std::uint64_t bits = masks[g]; bits != 0; bits &= bits - 1)
+                    f(static_cast<std::uint32_t>(first + g * kColumnGroup + lowestSetBit(bits)));
+            }
+        });
+    }
+
+    void clear() {
+        pages.clear();
+        extent = 0;
+    }
+};
+
+// ===========================
+// LazyIndex: індекс, що будується цілком при першому запиті. Поки ним не скористалися,
+// прийоми й завантаження його не оновлюють (більшість клінік рідкісних пошуків не робить).
+// Побудований індекс спільний для копій таблиці; таблиця, що змінюється, відокремлює свою
+// копію (writable). Побудова — під м'ютексом: одну таблицю можуть одночасно читати кілька
+// копій клініки з різних потоків
+// ===========================
+template <class Index>
+class LazyIndex {
+private:
+    mutable std::mutex mutex;
+    mutable std::shared_ptr<Index> index; // nullptr — ще не побудовано
+
+    std::shared_ptr<Index> shared() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return index;
+    }
+
+public:
+    LazyIndex() = default;
+    LazyIndex(const LazyIndex& other) : index(other.shared()) {}
+    LazyIndex& operator=(const LazyIndex& other) {
+        if (this != &other) {
+            std::shared_ptr<Index> copy = other.shared();
+            std::lock_guard<std::mutex> lock(mutex);
+            index = std::move(copy);
+        }
+        return *this;
+    }
+
+    // Побудований індекс; build(Index&) заповнює новий при першому зверненні
+    template <class Build>
+    std::shared_ptr<const Index> get(Build&& build) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!index) {
+            auto built = std::make_shared<Index>();
+            build(*built);
+            index = std::move(built);
+        }
+        return index;
+    }
+
+    // Індекс для зміни таблиці, якою володіє одна клініка (nullptr — ще не побудовано)
+    Index* writable() {
+        if (index && index.use_count() > 1) index = std::make_shared<Index>(*index);
+        return index.get();
+    }
+
+    // Після заміни всіх записів індекс будується наново при наступному запиті
+    void reset() { index.reset(); }
+};
+
+// Результат Polyclinic::fuzzyFind
+struct FuzzyMatch {
+    PatientId id;
+    int distance; // відстань Левенштейна між згорнутими іменами
+};
+
+// Звідки клініка бере пам'ять для пацієнтів
+enum class PatientMemory {
+    Heap, // кожен пацієнт і рядок — окрема алокація в купі
+    Arena // власна арена: великі блоки monotonic_buffer_resource, звільняються цілком разом із клінікою
+};
+
+// ===========================
+// Polyclinic: зберігає ПОЛІМОРФНИХ пацієнтів як незмінні спільні записи (SharedPatient) у SlotMap.
+// Копія клініки ділить таблицю записів (copy-on-write, O(1)); перша зміна копії копіює лише
+// вказівники на сторінки записів та індексів, а кожна зміна — сторінки, які зачіпає
+// п.8: saveToFile() — «1 пацієнт = 1 рядок», loadFromFile() — зворотне читання
+// п.9: кидання виключень у помилкових ситуаціях
+// ===========================
+class Polyclinic {
+private:
+    std::string name;
+    std::string address;
+    int doctorsCount{};
+
+    using ArenaList = std::vector<std::shared_ptr<std::pmr::monotonic_buffer_resource>>;
+
+    // Таблиця записів, спільна для копій клініки, доки одна з них не зміниться. Тоді клініка
+    // отримує власну копію таблиці, але записи й індекси всередині неї ділять сторінки (сегменти
+    // SlotMap, блоки списків, сторінки колонок) з оригіналом: копія коштує O(n / розмір сторінки),
+    // а кожна зміна відокремлює лише сторінки, які зачіпає (див. benchCopyOnWrite)
+    struct PatientTable {
+        ArenaList arenas;               // арени, в яких лежать записи (оголошені ДО records — переживають їх)
+        std::vector<std::shared_ptr<SymbolPool>> pools; // пули інших клінік, на які посилаються влиті записи
+        SlotMap<SharedPatient> records; // гетерогенний список (різні підтипи) + стабільні PatientId
+        NameIndex byName;               // індекси оновлюються в точках вставки й видалення
+        AgeIndex byAge;
+        TermIndex byTerm;
+        LazyIndex<NamePrefixIndex> byPrefix; // будується при першому suggestByName
+        LazyIndex<TrigramIndex> byTrigram;   // будується при першому fuzzyFind
+        PatientColumns columns;         // вік і тип за слотом — для аналітики без віртуальних викликів
+    };
+
+    bool arenaMode = false;                         // PatientMemory::Arena
+    std::shared_ptr<const PatientTable> table;      // читання — через const: спільні сторінки не відокремлюються
+    std::pmr::memory_resource* resource;            // звідки беруться нові пацієнти (в Arena — арена лише цієї клініки)
+    std::shared_ptr<SymbolPool> symbols;            // інтерновані поля пацієнтів (спільний із копіями клініки)
+    std::unique_ptr<MutationJournal> journal;       // журнал змін (якщо підключено openJournal)
+    JournalMark journalMark;                        // позиція журналу, яку вже містить стан без журналу
+
+    // Інкрементальний saveToFile: файл останнього збереження, кінець кожного рядка в ньому
+    // і кількість перших пацієнтів, що не змінились відтоді (наступне збереження переписує
+    // файл лише з першого зміненого рядка)
+    mutable std::string savedPath;
+    mutable std::vector<std::uint64_t> savedLineEnds;
+    mutable std::filesystem::file_time_type savedWriteTime;
+    mutable std::size_t cleanPrefix = 0;
+    mutable std::uint64_t savedMarkBytes = 0; // службовий рядок позиції журналу після пацієнтів
+
+public:
+    // Конструктори
+    Polyclinic()
+        : name("Без назви"), address("Невідомо"), doctorsCount(0), table(std::make_shared<PatientTable>()),
+        resource(std::pmr::get_default_resource()), symbols(std::make_shared<SymbolPool>()) {
+    }
+
+    Polyclinic(std::string name, std::string address, int doctors, PatientMemory memory = PatientMemory::Heap)
+        : name(std::move(name)), address(std::move(address)),
+        doctorsCount(doctors < 0 ? 0 : doctors), arenaMode(memory == PatientMemory::Arena),
+        table(std::make_shared<PatientTable>()),
+        resource(arenaMode ? newArena(mutableTable().arenas) : std::pmr::get_default_resource()),
+        symbols(std::make_shared<SymbolPool>()) {
+    }
+
+    // Пацієнти в чужому ресурсі (має пережити клініку і всі її копії; копії, що змінюються
+    // з різних потоків, потребують потокобезпечного ресурсу). Для LoadMode::Parallel ресурс
+    // не мусить бути потокобезпечним: потоки розбирають у власні арени клініки
+    Polyclinic(std::string name, std::string address, int doctors, std::pmr::memory_resource* memory)
+        : name(std::move(name)), address(std::move(address)),
+        doctorsCount(doctors < 0 ? 0 : doctors), table(std::make_shared<PatientTable>()),
+        resource(memory), symbols(std::make_shared<SymbolPool>()) {
+    }
+
+    // Копія за O(1): таблиця записів і пул інтернованих полів спільні, поки одна з клінік не
+    // зміниться (тоді вона отримує власну таблицю — див. mutableRecords). PatientId оригіналу
+    // дійсні й у копії. Копія не успадковує журнал (він належить одному об'єкту), але пам'ятає його позицію
+    Polyclinic(const Polyclinic& other)
+        : name(other.name), address(other.address), doctorsCount(other.doctorsCount),
+        arenaMode(other.arenaMode), table(other.table), resource(other.resource), symbols(other.symbols),
+        journalMark(other.currentJournalMark()) {
+    }
+
+    // Переміщення: таблиця записів, журнал і стан інкрементального збереження переходять без
+    // копіювання. Джерело лишається порожньою клінікою з тим самим пулом і придатне до використання
+    Polyclinic(Polyclinic&& other) noexcept { takeFrom(other); }
+
+    Polyclinic& operator=(Polyclinic&& other) noexcept {
+        if (this != &other) takeFrom(other);
+        return *this;
+    }
+
+    void printInfo() const {
+        std::cout << "Поліклініка '" << name << "' за адресою " << address
+            << " | лікарів: " << doctorsCount
+            << " | пацієнтів: " << getPatientsCount() << "\n";
+    }
+
+    void printAllPatients() const {
+        if (table->records.empty()) {
+            std::cout << "  [пацієнтів немає]\n";
+            return;
+        }
+        for (const auto& p : table->records) p->printInfo(); // поліморфний виклик
+    }
+
+    // Додавання / видалення пацієнтів (кожна зміна дописується в журнал, якщо він підключений).
+    // PatientId лишається дійсним, доки пацієнта не видалено з цієї клініки
+    PatientId addPatient(const Patient& p) { return append(sharePatient(p.clone(mutableResource(), *symbols))); }
+
+    // Готовий об'єкт переходить у клініку без клонування (інтерновані поля переводяться в її пул).
+    // Ресурс пам'яті, з якого його розміщено, має пережити клініку
+    PatientId addPatient(PatientPtr p) {
+        if (&p->symbolPool() != symbols.get()) p->rebindSymbols(*symbols);
+        return append(sharePatient(std::move(p)));
+    }
+
+    PatientId addPatient(std::unique_ptr<Patient> p) {
+        if (&p->symbolPool() != symbols.get()) p->rebindSymbols(*symbols);
+        return append(SharedPatient(std::move(p)));
+    }
+
+    // Будує T (Patient, ChildPatient або ElderPatient) одразу в пам'яті клініки: args — поля
+    // конструктора T без пулу й алокатора. Кожен рядок копіюється один раз, без тимчасового об'єкта
+    template <class T, class... Args>
+    PatientId emplacePatient(Args&&... args) {
+        static_assert(std::is_base_of_v<Patient, T>, "emplacePatient: T має бути підтипом Patient");
+        std::pmr::memory_resource* target = mutableResource();
+        return append(std::allocate_shared<T>(std::pmr::polymorphic_allocator<T>(target),
+            std::forward<Args>(args)..., *symbols));
+    }
+
+    PatientId addChild(std::string_view pname, int age, std::string_view disease, std::string_view parentContact) {
+        return emplacePatient<ChildPatient>(pname, age, disease, parentContact);
+    }
+
+    PatientId addElder(std::string_view pname, int age, std::string_view disease,
+        std::string_view allergies, std::string_view contraindications) {
+        return emplacePatient<ElderPatient>(pname, age, disease, allergies, contraindications);
+    }
+
+    // Пакетний прийом: місце резервується один раз. patients — контейнер пацієнтів
+    // (Patient, ChildPatient, ...) або вказівників на них (SharedPatient, PatientPtr, const Patient*).
+    // Повертає кількість доданих
+    template <class Range>
+    std::size_t addPatients(const Range& patients) {
+        mutableRecords().reserveMore(static_cast<std::size_t>(std::distance(std::begin(patients), std::end(patients))));
+        std::pmr::memory_resource* target = mutableResource();
+        std::size_t added = 0;
+        for (const auto& p : patients) {
+            append(sharePatient(patientOf(p).clone(target, *symbols)));
+            ++added;
+        }
+        return added;
+    }
+
+    // Видаляє всіх пацієнтів, для яких pred(const Patient&) == true, за один прохід;
+    // порядок решти зберігається. Повертає кількість видалених
+    template <class Pred>
+    std::size_t removeIf(Pred pred) {
+        std::vector<std::size_t> doomed;
+        for (std::size_t i = 0; i < table->records.size(); ++i) {
+            if (pred(static_cast<const Patient&>(*table->records[i]))) doomed.push_back(i);
+        }
+        return eraseIndices(doomed);
+    }
+
+    // Видаляє пацієнтів на позиціях sortedIndices (за зростанням) за один прохід.
+    // Не кидає: позиції за межами списку, повтори й порушення порядку пропускаються.
+    // Повертає кількість видалених
+    std::size_t removeIndices(const std::vector<std::size_t>& sortedIndices) {
+        std::vector<std::size_t> valid;
+        valid.reserve(sortedIndices.size());
+        for (const std::size_t index : sortedIndices) {
+            if (index < table->records.size() && (valid.empty() || index > valid.back())) valid.push_back(index);
+        }
+        return eraseIndices(valid);
+    }
+
+    // п.9: кидати виключення при видаленні з порожньої клініки
+    void removeLastPatient() {
+        if (table->records.empty()) throw EmptyClinicError("Немає пацієнтів для видалення");
+        if (journal) journal->logRemoveLast();
+        eraseAt(table->records.size() - 1);
+    }
+
+    // п.9: кидати виключення при неправильному індексі
+    void removePatientByIndex(size_t index) {
+        if (index >= table->records.size()) throw PatientIndexError("Індекс за межами діапазону");
+        if (journal) journal->logRemoveAt(index);
+        eraseAt(index);
+    }
+
+    // O(1) виписка за PatientId: на звільнене місце переходить останній пацієнт
+    // (порядок списку змінюється, PatientId інших пацієнтів — ні)
+    void removePatient(PatientId id) {
+        const std::size_t index = table->records.indexOf(id);
+        if (index == SlotMap<SharedPatient>::npos) throw PatientIndexError("Пацієнта вже видалено (застарілий PatientId)");
+        if (journal) journal->logSwapRemoveAt(index);
+        eraseSwapAt(index);
+    }
+
+    int getPatientsCount() const { return static_cast<int>(table->records.size()); }
+
+    // nullptr, якщо пацієнта вже видалено
+    const Patient* getPatient(PatientId id) const {
+        const SharedPatient* p = table->records.find(id);
+        return p ? p->get() : nullptr;
+    }
+
+    // PatientId пацієнта на позиції index (PatientId{} — за межами списку)
+    PatientId getPatientId(size_t index) const {
+        return index < table->records.size() ? table->records.idAt(index) : PatientId{};
+    }
+
+    // Усі пацієнти з іменем name за O(1) в середньому (порядок не визначено)
+    std::vector<PatientId> findByName(std::string_view pname) const {
+        std::vector<PatientId> found;
+        table->byName.forEachCandidate(pname, [&](PatientId id) {
+            if (getPatient(id)->getName() == pname) found.push_back(id);
+        });
+        return found;
+    }
+
+    // Пацієнт, тотожний за Patient::operator== (ім'я + вік); PatientId{}, якщо такого немає
+    PatientId findByIdentity(std::string_view pname, int age) const {
+        PatientId found;
+        table->byName.forEachCandidate(pname, [&](PatientId id) {
+            const Patient* p = getPatient(id);
+            if (p->getAge() == age && p->getName() == pname) found = id;
+        });
+        return found;
+    }
+
+    PatientId findByIdentity(const Patient& p) const { return findByIdentity(p.getName(), p.getAge()); }
+
+    // Пошук за словами діагнозу, алергій чи протипоказань (без урахування регістру)
+    std::vector<PatientId> findByTerm(TermField field, std::string_view text) const { return findAll({ { field, text } }); }
+
+    // AND: пацієнти, що задовольняють кожну умову. Результат — за зростанням номера слота
+    std::vector<PatientId> findAll(const std::vector<TermClause>& clauses) const {
+        std::vector<const PostingList*> lists;
+        for (const auto& clause : clauses) {
+            const auto clauseLists = table->byTerm.listsFor(clause);
+            if (clauseLists.empty()) return {};
+            lists.insert(lists.end(), clauseLists.begin(), clauseLists.end());
+        }
+        if (lists.empty() || std::find(lists.begin(), lists.end(), nullptr) != lists.end()) return {};
+        return idsOfSlots(PostingList::intersect(std::move(lists)));
+    }
+
+    // OR: пацієнти, що задовольняють хоча б одну умову (слова однієї умови — через AND)
+    std::vector<PatientId> findAny(const std::vector<TermClause>& clauses) const {
+        std::vector<std::uint32_t> slots;
+        for (const auto& clause : clauses) {
+            const auto lists = table->byTerm.listsFor(clause);
+            if (lists.empty() || std::find(lists.begin(), lists.end(), nullptr) != lists.end()) continue;
+            const auto matched = PostingList::intersect(lists);
+            slots.insert(slots.end(), matched.begin(), matched.end());
+        }
+        std::sort(slots.begin(), slots.end());
+        slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+        return idsOfSlots(slots);
+    }
+
+    // Підказки для реєстратури: до maxResults пацієнтів, чиє ім'я починається з prefix
+    // (без урахування регістру, є/е, ї/і, й/и, ґ/г і апострофів), за алфавітом
+    std::vector<PatientId> suggestByName(std::string_view prefix, std::size_t maxResults = 10) const {
+        std::vector<PatientId> found;
+        const auto index = table->byPrefix.get([&](NamePrefixIndex& built) { built.build(slotNames(*table)); });
+        index->forEachWithPrefix(prefix, maxResults,
+            [&](std::uint32_t slot) { found.push_back(table->records.idOfSlot(slot)); });
+        return found;
+    }
+
+    // Нечіткий пошук імені з паперових форм: до maxResults пацієнтів, чиє ім'я (після foldName)
+    // на відстані Левенштейна не більше maxDistance. Кандидатів відбирає індекс триграм, відстань
+    // рахується лише для них. Порядок: менша відстань, більше спільних триграм, номер слота
+    std::vector<FuzzyMatch> fuzzyFind(std::string_view pname, std::size_t maxResults, int maxDistance = 2) const {
+        std::vector<FuzzyMatch> found;
+        std::vector<std::size_t> shared;
+        std::string folded;
+        std::u32string wanted;
+        std::u32string other;
+        foldName(pname, folded);
+        toCodepoints(folded, wanted);
+        const auto trigrams = table->byTrigram.get([&](TrigramIndex& built) { built.build(slotNames(*table)); });
+        trigrams->forEachCandidate(pname, maxDistance, [&](std::uint32_t slot, std::size_t hits) {
+            const PatientId id = table->records.idOfSlot(slot);
+            foldName(getPatient(id)->getName(), folded);
+            toCodepoints(folded, other);
+            const int distance = boundedEditDistance(wanted, other, maxDistance);
+            if (distance > maxDistance) return;
+            found.push_back({ id, distance });
+            shared.push_back(hits);
+        });
+        std::vector<std::size_t> order(found.size());
+        for (std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+        const auto rank = [&](std::size_t a, std::size_t b) {
+            if (found[a].distance != found[b].distance) return found[a].distance < found[b].distance;
+            return shared[a] != shared[b] ? shared[a] > shared[b] : a < b;
+        };
+        const std::size_t keep = std::min(maxResults, order.size());
+        std::partial_sort(order.begin(), order.begin() + static_cast<std::ptrdiff_t>(keep), order.end(), rank);
+        std::vector<FuzzyMatch> best;
+        best.reserve(keep);
+        for (std::size_t i = 0; i < keep; ++i) best.push_back(found[order[i]]);
+        return best;
+    }
+
+    // Кількість пацієнтів віку age — O(1) для віку 0..AgeIndex::kMaxAge
+    std::size_t countByAge(int age) const { return table->byAge.countAt(age); }
+
+    // Кількість пацієнтів віком від lo до hi включно (наприклад, неповнолітні — 0..17)
+    std::size_t countByAge(int lo, int hi) const { return table->byAge.countInRange(lo, hi); }
+
+    // f(PatientId, const Patient&) для кожного пацієнта віком від lo до hi включно, за
+    // зростанням віку (пацієнти однакового віку — у невизначеному порядку)
+    template <class F>
+    void rangeByAge(int lo, int hi, F&& f) const {
+        table->byAge.forEachInRange(lo, hi, [&](PatientId id) { f(id, *getPatient(id)); });
+    }
+
+    // Аналітика за колонками віку й типу (SIMD, без звернень до самих записів).
+    // Наприклад, неповнолітні з потребою дозволу: count(ColumnFilter::of(PatientType::Child).ages(0, 17))
+    std::size_t count(const ColumnFilter& where) const { return table->columns.count(where); }
+
+    // Сума віку пацієнтів, що проходять where (середній вік — sumAges / count)
+    std::int64_t sumAges(const ColumnFilter& where) const { return table->columns.sumAges(where); }
+
+    // Кількість пацієнтів кожного PatientType серед тих, що проходять where
+    std::array<std::size_t, 3> histogram(const ColumnFilter& where) const { return table->columns.histogram(where); }
+
+    // Пацієнти, що проходять where, за зростанням номера слота
+    std::vector<PatientId> filter(const ColumnFilter& where) const {
+        std::vector<PatientId> found;
+        table->columns.forEachMatch(where, [&](std::uint32_t slot) { found.push_back(table->records.idOfSlot(slot)); });
+        return found;
+    }
+
+    // Кількість пацієнтів із діагнозом disease: рядок шукається в пулі клініки один раз,
+    // далі — порівняння 32-бітних номерів. Записи, влиті з інших клінік, лежать у своїх пулах:
+    // для них номер шукається в пулі джерела при кожній зміні пулу між сусідніми записами
+    std::size_t countWithDisease(std::string_view disease) const {
+        const SymbolPool::Id id = symbols->find(disease);
+        if (id == SymbolPool::kNotFound && table->pools.empty()) return 0;
+        const SymbolPool* pool = symbols.get();
+        SymbolPool::Id wanted = id;
+        std::size_t count = 0;
+        for (const auto& p : table->records) {
+            if (&p->symbolPool() != pool) {
+                pool = &p->symbolPool();
+                wanted = pool == symbols.get() ? id : pool->find(disease);
+            }
+            count += p->diseaseSymbol() == wanted ? 1 : 0;
+        }
+        return count;
+    }
+
+    const Patient* getPatientPtr(size_t index) const {
+        if (index < table->records.size()) return table->records[index].get();
+        return nullptr;
+    }
+
+    // Оператори (логіка як раніше; видалення може кинути EmptyClinicError)
+    Polyclinic& operator++() { addPatient(Patient{}); return *this; }
+    Polyclinic operator++(int) { Polyclinic t(*this); ++(*this); return t; }
+    Polyclinic& operator--() { removeLastPatient(); return *this; }
+    Polyclinic operator--(int) { Polyclinic t(*this); --(*this); return t; }
+
+    // Ліва частина — за значенням: копія O(1), тимчасова клініка переміщується
+    friend Polyclinic operator+(Polyclinic lhs, const Polyclinic& rhs) {
+        lhs += rhs;
+        return lhs;
+    }
+    friend Polyclinic operator+(Polyclinic lhs, Polyclinic&& rhs) {
+        lhs += std::move(rhs);
+        return lhs;
+    }
+
+    // Записи іншої клініки додаються спільними, без клонування (її арени й пул лишаються
+    // живими, поки є записи) — див. appendTable
+    Polyclinic& operator+=(const Polyclinic& other) {
+        this->name = this->name + " + " + other.name;
+        this->doctorsCount += other.doctorsCount;
+        const std::shared_ptr<const PatientTable> source = other.table; // other може бути *this
+        logAdds(*source);
+        appendTable(*source, other.symbols, false);
+        return *this;
+    }
+
+    // Злиття з тимчасовою клінікою: записи переносяться сторінками, без клонування і без
+    // лічильників посилань. Порожня клініка без журналу (наприклад, новий регіональний звіт)
+    // забирає таблицю цілком — O(1), і PatientId джерела дійсні в ній. other лишається
+    // порожньою; її журнал отримує запис Clear (після записів Add у журнал цієї клініки)
+    Polyclinic& operator+=(Polyclinic&& other) {
+        if (&other == this) return *this += static_cast<const Polyclinic&>(other);
+        logAdds(*other.table);
+        if (other.journal) other.journal->logClear();
+        this->name = this->name + " + " + other.name;
+        this->doctorsCount += other.doctorsCount;
+        std::shared_ptr<const PatientTable> source = std::exchange(other.table, emptyTable());
+        const std::shared_ptr<SymbolPool> sourcePool = other.symbols;
+        other.invalidateSavedFile();
+
+        if (!journal && table->records.neverIssuedIds() && source.use_count() == 1) {
+            table = std::move(source); // попередні арени цієї клініки не містили записів
+            if (sourcePool != symbols) mutableTable().pools.push_back(sourcePool);
+            if (arenaMode) resource = newArena(mutableTable().arenas);
+            return *this;
+        }
+        appendTable(*source, sourcePool, source.use_count() == 1); // інакше записи ще потрібні копіям other
+        return *this;
+    }
+
+    bool operator==(const Polyclinic& other) const {
+        return getPatientsCount() == other.getPatientsCount();
+    }
+    bool operator!=(const Polyclinic& other) const { return !(*this == other); }
+
+    // п.8 + п.9: збереження у файл (кидає FileSaveError при невдачі).
+    // Повторне збереження в той самий файл інкрементальне: незмінні перші рядки лишаються
+    // на місці, файл обрізається на першому зміненому рядку і дописується далі. Тож після
+    // нових прийомів (додавання в кінець) час пропорційний кількості змін, а не пацієнтів.
+    // Файл пишеться в двійковому режимі: кінець рядка завжди '\n' (зсуви мають бути точними).
+    // Якщо клініка веде журнал, останній рядок — «#journal|епоха|зсув»: loadFromFile відновлює
+    // з нього позицію, і openJournal не відтворює вдруге зміни, які файл уже містить
+    void saveToFile(const std::string& filepath) const {
+        const std::size_t keep = reusableLines(filepath);
+        const std::uint64_t keepBytes = keep > 0 ? savedLineEnds[keep - 1] : 0;
+        savedPath.clear(); // якщо запис урветься, наступне збереження буде повним
+
+        std::error_code ec;
+        if (keep > 0) std::filesystem::resize_file(filepath, keepBytes, ec);
+        std::ofstream ofs(filepath, std::ios::binary | (keep > 0 && !ec ? std::ios::app : std::ios::trunc));
+        if (!ofs) throw FileSaveError("Не вдається відкрити файл: " + filepath);
+
+        const std::size_t from = keep > 0 && !ec ? keep : 0;
+        writeLines(from, from > 0 ? keepBytes : 0, [&](std::string_view block) {
+            ofs.write(block.data(), static_cast<std::streamsize>(block.size()));
+        });
+        if (!ofs.flush()) throw FileSaveError("Помилка запису файлу: " + filepath);
+        ofs.close();
+
+        rememberSavedFile(filepath);
+    }
+
+    // Знімок у текстовому форматі, стійкий до збою: повний запис у тимчасовий файл, fsync,
+    // rename поверх filepath і fsync каталогу. Durability::None — для масового імпорту.
+    // Після нього звичайний saveToFile у той самий файл знову інкрементальний
+    SaveStats saveToFileAtomic(const std::string& filepath, Durability durability = Durability::Fsync) const {
+        savedPath.clear();
+        AtomicFileWriter out(filepath, durability);
+        writeLines(0, 0, [&](std::string_view block) { out.write(block.data(), block.size()); });
+        const SaveStats stats = out.commit();
+        rememberSavedFile(filepath);
+        return stats;
+    }
+
+    // Бінарний колонковий знімок (формат описано біля SnapshotColumn); кидає FileSaveError.
+    // Пишеться атомарно (тимчасовий файл + rename), тож збій не лишає обрізаного знімка
+    SaveStats saveSnapshot(const std::string& filepath, Durability durability = Durability::Fsync) const {
+        const std::size_t n = table->records.size();
+        std::vector<std::uint8_t> types(n);
+        std::vector<std::int32_t> ages(n);
+        std::vector<std::string_view> names(n), contacts(n); // майже унікальні — без словника
+        DictionaryColumnWriter diseases(n), allergies(n), contraindications(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            const Patient& p = *table->records[i];
+            types[i] = static_cast<std::uint8_t>(p.type());
+            ages[i] = p.getAge();
+            names[i] = p.getName();
+            diseases.push(p.getDisease());
+            // Поля, яких підтип не має, кодуються порожнім рядком (одне значення словника)
+            const auto* child = p.type() == PatientType::Child ? static_cast<const ChildPatient*>(&p) : nullptr;
+            const auto* elder = p.type() == PatientType::Elder ? static_cast<const ElderPatient*>(&p) : nullptr;
+            if (child) contacts[i] = child->getParentContact();
+            allergies.push(elder ? std::string_view(elder->getAllergies()) : std::string_view());
+            contraindications.push(elder ? std::string_view(elder->getContraindications()) : std::string_view());
+        }
+
+        AtomicFileWriter ofs(filepath, durability);
+        writePod(ofs, kSnapshotMagic);
+        writePod(ofs, kSnapshotVersion);
+        writePod(ofs, static_cast<std::uint64_t>(n));
+        writePod(ofs, kSnapshotRequiredColumns + 1);
+        writePod(ofs, std::uint32_t{ 0 });
+
+        writeColumnHeader(ofs, SnapshotColumn::Type, 1, n);
+        ofs.write(reinterpret_cast<const char*>(types.data()), n);
+        writeColumnHeader(ofs, SnapshotColumn::Age, 4, n * sizeof(std::int32_t));
+        ofs.write(reinterpret_cast<const char*>(ages.data()), n * sizeof(std::int32_t));
+        writeRawTextColumn(ofs, SnapshotColumn::Name, names);
+        diseases.writeTo(ofs, SnapshotColumn::Disease);
+        writeRawTextColumn(ofs, SnapshotColumn::ParentContact, contacts);
+        allergies.writeTo(ofs, SnapshotColumn::Allergies);
+        contraindications.writeTo(ofs, SnapshotColumn::Contraindications);
+        const JournalMark mark = currentJournalMark();
+        writeColumnHeader(ofs, SnapshotColumn::JournalMark, 0, 16);
+        writePod(ofs, mark.epoch);
+        writePod(ofs, std::uint32_t{ 0 });
+        writePod(ofs, mark.offset);
+        return ofs.commit();
+    }
+
+    // Завантаження бінарного знімка (кидає FileLoadError). Файл відображається в пам'ять,
+    // числові колонки копіюються одним memcpy, рядки будуються прямо з колонок, а кожне
+    // значення словника інтернованих полів інтернується один раз (записи отримують номери)
+    void loadSnapshot(const std::string& filepath) {
+        const MappedFile file(filepath);
+        BinaryReader in(file.begin(), file.end());
+        if (in.read<std::uint32_t>() != kSnapshotMagic) throw FileLoadError("Файл не є знімком поліклініки: " + filepath);
+        const auto version = in.read<std::uint32_t>();
+        if (version == 0 || version > kSnapshotVersion) throw FileLoadError("Непідтримувана версія знімка: " + filepath);
+        const auto n = in.read<std::uint64_t>();
+        const auto columnCount = in.read<std::uint32_t>();
+        in.read<std::uint32_t>(); // резерв
+        in.checkedCount(n, 1); // щонайменше байт типу на запис
+
+        std::vector<std::uint8_t> types;
+        std::vector<std::int32_t> ages;
+        DictionaryColumn text[5]; // Name .. Contraindications
+        JournalMark mark;
+        bool present[kSnapshotRequiredColumns] = {};
+        for (std::uint32_t c = 0; c < columnCount; ++c) {
+            const auto id = in.read<std::uint32_t>();
+            const auto width = in.read<std::uint32_t>();
+            const auto bytes = in.read<std::uint64_t>();
+            const char* data = in.take(bytes);
+            if (id == static_cast<std::uint32_t>(SnapshotColumn::JournalMark)) {
+                BinaryReader markIn(data, data + bytes);
+                mark.epoch = markIn.read<std::uint32_t>();
+                markIn.read<std::uint32_t>();
+                mark.offset = markIn.read<std::uint64_t>();
+                continue;
+            }
+            if (id >= kSnapshotRequiredColumns) continue; // колонка новішої версії
+            present[id] = true;
+            if (id == static_cast<std::uint32_t>(SnapshotColumn::Type)) {
+                if (width != 1 || bytes != n) throw FileLoadError("Пошкоджений знімок: колонка типів");
+                types.resize(static_cast<std::size_t>(n));
+                std::memcpy(types.data(), data, types.size());
+            }
+            else if (id == static_cast<std::uint32_t>(SnapshotColumn::Age)) {
+                if (width != 4 || bytes != n * sizeof(std::int32_t)) throw FileLoadError("Пошкоджений знімок: колонка віку");
+                ages.resize(static_cast<std::size_t>(n));
+                std::memcpy(ages.data(), data, ages.size() * sizeof(std::int32_t));
+            }
+            else {
+                text[id - static_cast<std::uint32_t>(SnapshotColumn::Name)] = DictionaryColumn::decode(data, bytes, width, n);
+            }
+        }
+        for (const bool has : present)
+            if (!has) throw FileLoadError("Пошкоджений знімок: бракує колонки");
+
+        const auto& [names, diseases, contacts, allergies, contraindications] = text;
+        for (std::size_t i = 0; i < n; ++i) {
+            if (types[i] > static_cast<std::uint8_t>(PatientType::Elder))
+                throw FileLoadError("Пошкоджений знімок: невідомий тип запису " + std::to_string(i));
+        }
+        const auto diseaseIds = diseases.internInto(*symbols);
+        const auto allergyIds = allergies.internInto(*symbols);
+        const auto contraindicationIds = contraindications.internInto(*symbols);
+        ArenaList loadedArenas;
+        std::pmr::memory_resource* target = reloadResource(loadedArenas);
+        std::vector<SharedPatient> loaded;
+        loaded.reserve(static_cast<std::size_t>(n));
+        for (std::size_t i = 0; i < n; ++i) {
+            loaded.push_back(makeSharedPatient(target, *symbols, static_cast<PatientType>(types[i]), names.at(i), ages[i],
+                diseases.symbolAt(diseaseIds, i), contacts.at(i),
+                allergies.symbolAt(allergyIds, i), contraindications.symbolAt(contraindicationIds, i)));
+        }
+        replacePatients(loaded, loadedArenas, target);
+        journalMark = mark;
+        invalidateSavedFile();
+        restartJournal();
+    }
+
+    // Підключає журнал змін: відтворює записи, яких ще немає у поточному стані (після
+    // loadSnapshot — лише ті, що новіші за JournalMark знімка), обрізає пошкоджений хвіст
+    // і далі дописує кожну зміну. Викликати на старті, після завантаження знімка
+    void openJournal(const std::string& path, std::size_t groupCommitRecords = 64) {
+        if (journal) {
+            journalMark = journal->position();
+            journal.reset(); // попередній журнал комітиться і закривається
+        }
+        std::uint32_t epoch = journalMark.epoch + 1;
+        std::uint64_t validBytes = 0;
+        if (std::filesystem::exists(path)) {
+            const MappedFile file(path); // закривається до відкриття на запис (важливо для Windows)
+            std::uint32_t fileEpoch = 0;
+            if (MutationJournal::readEpoch(file, fileEpoch) && fileEpoch >= journalMark.epoch) {
+                const std::uint64_t from = fileEpoch == journalMark.epoch ? journalMark.offset : 0;
+                const std::uint64_t valid = MutationJournal::replay(file, from,
+                    [this](JournalOp op, BinaryReader& in) { applyJournalRecord(op, in); });
+                // Журнал тієї ж епохи коротший за позицію у знімку (втрачено незакомічені записи,
+                // які знімок уже містить) — дописувати в нього не можна, починаємо нову епоху
+                if (fileEpoch > journalMark.epoch || valid >= journalMark.offset) {
+                    epoch = fileEpoch;
+                    validBytes = valid;
+                }
+            }
+        }
+        journal = std::make_unique<MutationJournal>(path, epoch, validBytes, groupCommitRecords);
+    }
+
+    // Примусовий груповий коміт (наприклад, перед відповіддю клієнту)
+    void commitJournal() {
+        if (journal) journal->commit();
+    }
+
+    // Контрольна точка: знімок на диску + порожній журнал нової епохи, щоб журнал не ріс
+    // безмежно. Збій між двома кроками безпечний завдяки JournalMark у знімку
+    void checkpoint(const std::string& snapshotPath) {
+        saveSnapshot(snapshotPath, Durability::Fsync); // знімок на диску раніше, ніж очиститься журнал
+        if (journal) journal->reset(journal->position().epoch + 1);
+    }
+
+    // Завантаження з файлу формату saveToFile (кидає FileLoadError).
+    // Список пацієнтів замінюється лише після успішного розбору всього файлу.
+    // Підключений журнал після завантаження починає нову епоху (див. restartJournal).
+    // threads — лише для LoadMode::Parallel (0 — кількість ядер)
+    void loadFromFile(const std::string& filepath, LoadMode mode = LoadMode::Stream, unsigned threads = 0) {
+        ArenaList loadedArenas;
+        std::pmr::memory_resource* target = reloadResource(loadedArenas);
+        std::vector<SharedPatient> loaded;
+        JournalMark mark;
+        if (mode == LoadMode::Parallel) mark = readParallel(filepath, loaded, threads, target, *symbols, loadedArenas);
+        else if (mode == LoadMode::Mapped) mark = readMapped(filepath, loaded, target, *symbols);
+        else mark = readStreamed(filepath, loaded, target, *symbols);
+        replacePatients(loaded, loadedArenas, target);
+        journalMark = mark;
+        invalidateSavedFile();
+        restartJournal();
+    }
+
+private:
+    static constexpr std::size_t kArenaBlockSize = 1 << 20; // перший блок арени; далі блоки ростуть
+
+    static std::pmr::memory_resource* newArena(ArenaList& list) {
+        list.push_back(std::make_shared<std::pmr::monotonic_buffer_resource>(kArenaBlockSize));
+        return list.back().get();
+    }
+
+    // Спільна порожня таблиця для переміщених клінік: перша зміна відокремить власну
+    static std::shared_ptr<const PatientTable> emptyTable() {
+        static const std::shared_ptr<const PatientTable> empty = std::make_shared<PatientTable>();
+        return empty;
+    }
+
+    void takeFrom(Polyclinic& other) noexcept {
+        name = std::move(other.name);
+        address = std::move(other.address);
+        doctorsCount = other.doctorsCount;
+        arenaMode = other.arenaMode;
+        table = std::exchange(other.table, emptyTable());
+        resource = other.resource;
+        symbols = other.symbols;
+        journal = std::move(other.journal);
+        journalMark = other.journalMark;
+        savedPath = std::move(other.savedPath);
+        savedLineEnds = std::move(other.savedLineEnds);
+        savedWriteTime = other.savedWriteTime;
+        cleanPrefix = other.cleanPrefix;
+        savedMarkBytes = other.savedMarkBytes;
+        other.invalidateSavedFile();
+    }
+
+    // Журнал цієї клініки отримує записи source ДО злиття (write-ahead)
+    void logAdds(const PatientTable& source) {
+        if (!journal) return;
+        for (const auto& p : source.records) journal->logAdd(*p);
+    }
+
+    // Записи source — у кінець цієї клініки (журнал уже записано, див. logAdds). Слоти source
+    // зсуваються на кількість власних слотів (SlotMap::append): записи дописуються сторінками,
+    // індекси зливаються зі зсувом без повторного хешування імен і розбору діагнозів.
+    // Ліниві індекси скидаються — побудуються при наступному запиті.
+    // steal — таблиця source (створена неконстантною) більше нікому не належить: записи переносяться
+    void appendTable(const PatientTable& source, const std::shared_ptr<SymbolPool>& sourcePool, bool steal) {
+        if (source.records.empty()) return;
+        keepAlive(source, sourcePool);
+        PatientTable& t = mutableTable();
+        const std::uint32_t slotOffset = steal
+            ? t.records.append(std::move(const_cast<PatientTable&>(source).records))
+            : t.records.append(source.records);
+        t.byName.append(source.byName, slotOffset);
+        t.byAge.append(source.byAge, slotOffset);
+        t.byTerm.append(source.byTerm, slotOffset);
+        t.columns.append(source.columns, slotOffset);
+        t.byPrefix.reset();
+        t.byTrigram.reset();
+    }
+
+    // Виписка всіх (запис Clear журналу); арени лишаються до знищення таблиці
+    void clearPatients() {
+        PatientTable& t = mutableTable();
+        t.records.clear();
+        t.byName.clear();
+        t.byAge.clear();
+        t.byTerm.clear();
+        t.columns.clear();
+        t.byPrefix.reset();
+        t.byTrigram.reset();
+        cleanPrefix = 0;
+    }
+
+    // Записи source лежать в її аренах і можуть посилатися на чужі пули — тримаємо їх живими
+    // разом із таблицею цієї клініки (викликати, коли таблиця вже власна)
+    void keepAlive(const PatientTable& source, const std::shared_ptr<SymbolPool>& sourcePool) {
+        const auto addOnce = [](auto& list, const auto& item) {
+            if (std::find(list.begin(), list.end(), item) == list.end()) list.push_back(item);
+        };
+        PatientTable& t = mutableTable();
+        for (const auto& arena : source.arenas) addOnce(t.arenas, arena);
+        for (const auto& pool : source.pools)
+            if (pool != symbols) addOnce(t.pools, pool);
+        if (sourcePool != symbols) addOnce(t.pools, sourcePool);
+    }
+
+    // Таблиця для зміни: спільну з іншою копією клініки спершу копіюємо (таблиці вказівників
+    // на сторінки, самі сторінки лишаються спільними). Арена, в яку писали обидві копії,
+    // лишається іншій — ця отримує нову
+    PatientTable& mutableTable() {
+        if (table.use_count() > 1) {
+            auto copy = std::make_shared<PatientTable>(*table);
+            if (arenaMode) resource = newArena(copy->arenas);
+            table = std::move(copy);
+        }
+        // Кожна таблиця створюється неконстантною (make_shared<PatientTable>) і тепер належить лише цій клініці
+        return const_cast<PatientTable&>(*table);
+    }
+
+    SlotMap<SharedPatient>& mutableRecords() { return mutableTable().records; }
+
+    // Ресурс для нового запису (після можливого відокремлення таблиці)
+    std::pmr::memory_resource* mutableResource() {
+        mutableRecords();
+        return resource;
+    }
+
+    // Ресурс для повної заміни пацієнтів (завантаження): клініка з власною ареною розбирає
+    // в НОВУ арену (у loadedArenas), а стара звільняється, щойно зникнуть її записи
+    std::pmr::memory_resource* reloadResource(ArenaList& loadedArenas) const {
+        return arenaMode ? newArena(loadedArenas) : resource;
+    }
+
+    // Незалежні роботи, кожна на своєму потоці (остання — на поточному); на одному ядрі — по черзі.
+    // Першу помилку кидає, коли завершилися всі
+    template <class... Tasks>
+    static void runConcurrently(Tasks&&... tasks) {
+        constexpr std::size_t kTasks = sizeof...(Tasks);
+        std::array<std::exception_ptr, kTasks> errors;
+        const bool parallel = std::thread::hardware_concurrency() > 1;
+        std::vector<std::thread> workers;
+        workers.reserve(kTasks);
+        std::size_t next = 0;
+        const auto launch = [&](auto& task) {
+            const std::size_t k = next++;
+            const auto guarded = [&task, &errors, k] {
+                try { task(); }
+                catch (...) { errors[k] = std::current_exception(); }
+            };
+            if (!parallel || k + 1 == kTasks) return guarded();
+            try { workers.emplace_back(guarded); }
+            catch (...) { guarded(); } // потік не створився — робота на поточному
+        };
+        (launch(tasks), ...);
+        for (auto& w : workers) w.join();
+        for (const auto& e : errors) {
+            if (e) std::rethrow_exception(e);
+        }
+    }
+
+    // Старі записи знищуються раніше за арени, в яких вони лежать. Індекси будуються цілком
+    // (а не по запису, як при прийомі), кожен на своєму потоці
+    void replacePatients(std::vector<SharedPatient>& loaded, ArenaList& loadedArenas,
+        std::pmr::memory_resource* target) {
+        PatientTable& t = mutableTable();
+        t.records.swapValues(loaded);
+        loaded.clear();
+        t.pools.clear();
+        const auto buildNames = [&t] {
+            t.byName.build(t.records.size(), [&t](std::size_t i) {
+                return std::pair<SlotId, std::string_view>(t.records.idAt(i), t.records[i]->getName());
+            });
+        };
+        const auto buildAges = [&t] {
+            t.byAge.build(t.records.size(), [&t](std::size_t i) {
+                return std::pair<SlotId, int>(t.records.idAt(i), t.records[i]->getAge());
+            });
+        };
+        const auto buildTerms = [&t] {
+            t.byTerm.build(t.records.size(), [&t](std::size_t i) {
+                return std::pair<std::uint32_t, const Patient*>(t.records.idAt(i).slot, t.records[i].get());
+            });
+        };
+        const auto buildColumns = [&t] {
+            t.columns.build(t.records.size(), [&t](std::size_t i) {
+                return std::pair<std::uint32_t, const Patient*>(t.records.idAt(i).slot, t.records[i].get());
+            });
+        };
+        runConcurrently(buildNames, buildAges, buildTerms, buildColumns);
+        t.byPrefix.reset();
+        t.byTrigram.reset();
+        if (arenaMode) resource = target;
+        t.arenas.swap(loadedArenas);
+    }
+
+    JournalMark currentJournalMark() const { return journal ? journal->position() : journalMark; }
+
+    // Пари (слот, ім'я) усіх записів — для індексів, що будуються цілком
+    static std::vector<std::pair<std::uint32_t, std::string_view>> slotNames(const PatientTable& t) {
+        std::vector<std::pair<std::uint32_t, std::string_view>> names;
+        names.reserve(t.records.size());
+        for (std::size_t i = 0; i < t.records.size(); ++i) names.emplace_back(t.records.idAt(i).slot, t.records[i]->getName());
+        return names;
+    }
+
+    // Завантаження при підключеному журналі не журналюється, тож стан у пам'яті — це вже файл,
+    // а не «файл + журнал». Журнал починає епоху, новішу і за свою, і за позицію у файлі:
+    // після перезапуску (той самий файл + openJournal) відтворяться лише зміни після завантаження
+    void restartJournal() {
+        if (!journal) return;
+        journal->reset(std::max(journal->position().epoch, journalMark.epoch) + 1);
+    }
+
+    // Позиція журналу зі службового рядка «#journal|епоха|зсув», якщо він останній у text
+    // (text — уже прочитаний кінець файлу; {} — рядка немає: файл збережено без журналу)
+    static JournalMark parseJournalMark(std::string_view text) {
+        constexpr std::size_t kTail = 64; // службовий рядок коротший
+        if (text.size() > kTail) text.remove_prefix(text.size() - kTail);
+        while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) text.remove_suffix(1);
+        constexpr std::string_view kPrefix = "#journal|";
+        const std::size_t start = text.rfind('\n') == std::string_view::npos ? 0 : text.rfind('\n') + 1;
+        text.remove_prefix(start);
+        if (text.substr(0, kPrefix.size()) != kPrefix) return {};
+        text.remove_prefix(kPrefix.size());
+        JournalMark mark;
+        const char* end = text.data() + text.size();
+        const auto epochEnd = std::from_chars(text.data(), end, mark.epoch);
+        if (epochEnd.ec != std::errc{} || epochEnd.ptr == end || *epochEnd.ptr != '|') return {};
+        const auto offsetEnd = std::from_chars(epochEnd.ptr + 1, end, mark.offset);
+        if (offsetEnd.ec != std::errc{} || offsetEnd.ptr != end) return {};
+        return mark;
+    }
+
+    // Єдина точка вставки: запис у журнал — ДО зміни в пам'яті (write-ahead)
+    PatientId append(SharedPatient p) {
+        if (journal) journal->logAdd(*p);
+        const Patient& record = *p; // запис незмінний — рядки живуть разом із ним
+        PatientTable& t = mutableTable();
+        const PatientId id = t.records.insert(std::move(p));
+        t.byName.insert(id, record.getName());
+        t.byAge.insert(id, record.getAge());
+        t.byTerm.insert(id.slot, record);
+        if (NamePrefixIndex* prefix = t.byPrefix.writable()) prefix->insert(id.slot, record.getName());
+        if (TrigramIndex* trigrams = t.byTrigram.writable()) trigrams->insert(id.slot, record.getName());
+        t.columns.insert(id.slot, record.type(), record.getAge());
+        return id;
+    }
+
+    // Прибирає з індексу запис на позиції index (викликати ДО видалення самого запису)
+    void unindex(std::size_t index) {
+        PatientTable& t = mutableTable();
+        const PatientId id = t.records.idAt(index);
+        const Patient& record = *std::as_const(t.records)[index];
+        t.byName.erase(id, record.getName());
+        t.byAge.erase(id, record.getAge());
+        t.byTerm.erase(id.slot, record);
+        if (NamePrefixIndex* prefix = t.byPrefix.writable()) prefix->erase(id.slot, record.getName());
+        if (TrigramIndex* trigrams = t.byTrigram.writable()) trigrams->erase(id.slot, record.getName());
+        t.columns.erase(id.slot);
+    }
+
+    std::vector<PatientId> idsOfSlots(const std::vector<std::uint32_t>& slots) const {
+        std::vector<PatientId> ids;
+        ids.reserve(slots.size());
+        for (const std::uint32_t slot : slots) ids.push_back(table->records.idOfSlot(slot));
+        return ids;
+    }
+
+    // Точки видалення: усе, що стояло на позиції index і далі, у файлі вже застаріло
+    void eraseAt(std::size_t index) {
+        unindex(index);
+        mutableRecords().eraseOrdered(index);
+        if (index < cleanPrefix) cleanPrefix = index;
+    }
+
+    void eraseSwapAt(std::size_t index) {
+        unindex(index);
+        mutableRecords().eraseSwap(index);
+        if (index < cleanPrefix) cleanPrefix = index;
+    }
+
+    // sortedIndices — коректні позиції за строгим зростанням
+    std::size_t eraseIndices(const std::vector<std::size_t>& sortedIndices) {
+        if (sortedIndices.empty()) return 0;
+        if (journal) journal->logRemoveIndices(sortedIndices);
+        for (const std::size_t index : sortedIndices) unindex(index);
+        mutableRecords().eraseSorted(sortedIndices);
+        if (sortedIndices.front() < cleanPrefix) cleanPrefix = sortedIndices.front();
+        return sortedIndices.size();
+    }
+
+    static const Patient& patientOf(const Patient& p) { return p; }
+    template <class Ptr>
+    static auto patientOf(const Ptr& p) -> decltype(static_cast<const Patient&>(*p)) { return *p; }
+
+    // Скільки перших рядків файлу filepath ще відповідають пацієнтам. Файл, змінений
+    // ззовні (інший розмір або час зміни), переписується повністю
+    std::size_t reusableLines(const std::string& filepath) const {
+        if (filepath != savedPath) return 0;
+        std::error_code ec;
+        const auto size = std::filesystem::file_size(filepath, ec);
+        if (ec || size != (savedLineEnds.empty() ? 0 : savedLineEnds.back()) + savedMarkBytes) return 0;
+        if (std::filesystem::last_write_time(filepath, ec) != savedWriteTime || ec) return 0;
+        return cleanPrefix < savedLineEnds.size() ? cleanPrefix : savedLineEnds.size();
+    }
+
+    // Серіалізує пацієнтів [from, кінець) у буфер і віддає його writeBlock блоками по ~1 МіБ;
+    // base — зсув першого рядка у файлі. Попутно оновлює кінці рядків для інкрементального збереження
+    template <class WriteBlock>
+    void writeLines(std::size_t from, std::uint64_t base, WriteBlock&& writeBlock) const {
+        constexpr std::size_t kFlushBlockSize = 1 << 20;
+        savedLineEnds.resize(from);
+        savedLineEnds.reserve(table->records.size());
+        SerializeBuffer out(kFlushBlockSize + 4096);
+        for (std::size_t i = from; i < table->records.size(); ++i) {
+            table->records[i]->serializeTo(out); // поліморфний виклик
+            out.append('\n');
+            savedLineEnds.push_back(base + out.size());
+            if (out.size() >= kFlushBlockSize) {
+                writeBlock(out.view());
+                base += out.size();
+                out.clear();
+            }
+        }
+        const std::size_t linesEnd = out.size();
+        const JournalMark mark = currentJournalMark();
+        if (mark.epoch != 0) { // файл без журналу лишається в старому форматі
+            out.append("#journal|");
+            out.append(std::to_string(mark.epoch));
+            out.append('|');
+            out.append(std::to_string(mark.offset));
+            out.append('\n');
+        }
+        savedMarkBytes = out.size() - linesEnd;
+        writeBlock(out.view());
+    }
+
+    void rememberSavedFile(const std::string& filepath) const {
+        std::error_code ec;
+        savedWriteTime = std::filesystem::last_write_time(filepath, ec);
+        if (ec) return; // без часу зміни не можемо довіряти файлу — наступне збереження повне
+        savedPath = filepath;
+        cleanPrefix = table->records.size();
+    }
+
+    // Після заміни всього списку пацієнтів (завантаження) файл треба переписати повністю
+    void invalidateSavedFile() {
+        savedPath.clear();
+        savedLineEnds.clear();
+        cleanPrefix = 0;
+    }
+
+    // Відтворення одного запису журналу (журнал у цей момент не підключений — нічого не дописується)
+    void applyJournalRecord(JournalOp op, BinaryReader& in) {
+        switch (op) {
+        case JournalOp::Add:
+            append(MutationJournal::decodePatient(in, mutableResource(), *symbols)); // журнал тут не підключений
+            break;
+        case JournalOp::RemoveAt: {
+            const auto index = in.read<std::uint64_t>();
+            if (index >= table->records.size()) throw FileLoadError("Журнал не відповідає стану поліклініки");
+            eraseAt(static_cast<std::size_t>(index));
+            break;
+        }
+        case JournalOp::RemoveLast:
+            if (table->records.empty()) throw FileLoadError("Журнал не відповідає стану поліклініки");
+            eraseAt(table->records.size() - 1);
+            break;
+        case JournalOp::SwapRemoveAt: {
+            const auto index = in.read<std::uint64_t>();
+            if (index >= table->records.size()) throw FileLoadError("Журнал не відповідає стану поліклініки");
+            eraseSwapAt(static_cast<std::size_t>(index));
+            break;
+        }
+        case JournalOp::RemoveIndices: {
+            const auto count = in.read<std::uint64_t>();
+            if (count > table->records.size()) throw FileLoadError("Журнал не відповідає стану поліклініки");
+            in.checkedCount(count, sizeof(std::uint64_t));
+            std::vector<std::size_t> indices(static_cast<std::size_t>(count));
+            for (auto& index : indices) {
+                const auto value = in.read<std::uint64_t>();
+                if (value >= table->records.size() || (&index != indices.data() && value <= *(&index - 1)))
+                    throw FileLoadError("Журнал не відповідає стану поліклініки");
+                index = static_cast<std::size_t>(value);
+            }
+            eraseIndices(indices); // журнал тут не підключений
+            break;
+        }
+        case JournalOp::Clear:
+            clearPatients();
+            break;
+        default:
+            throw FileLoadError("Пошкоджений журнал: невідома операція");
+        }
+    }
+
+    // Читаємо великими блоками в ОДИН буфер, що перевикористовується; обробляємо лише цілі
+    // рядки, а незавершений хвіст переносимо на початок буфера
+    // Повертає позицію журналу з останнього рядка файлу (див. parseJournalMark)
+    static JournalMark readStreamed(const std::string& filepath, std::vector<SharedPatient>& loaded,
+        std::pmr::memory_resource* target, SymbolPool& symbols) {
+        constexpr std::size_t kReadBlockSize = 1 << 20; // 1 МіБ
+
+        std::ifstream ifs(filepath, std::ios::binary);
+        if (!ifs) throw FileLoadError("Не вдається відкрити файл: " + filepath);
+
+        std::vector<char> buffer(kReadBlockSize);
+        std::size_t filled = 0;
+        std::size_t lineNo = 1;
+        JournalMark mark;
+        for (;;) {
+            ifs.read(buffer.data() + filled, static_cast<std::streamsize>(buffer.size() - filled));
+            filled += static_cast<std::size_t>(ifs.gcount());
+            if (ifs.bad()) throw FileLoadError("Помилка читання файлу: " + filepath);
+            const bool atEnd = ifs.eof();
+
+            std::size_t complete = filled;
+            if (!atEnd) {
+                const std::size_t lastNl = std::string_view(buffer.data(), filled).rfind('\n');
+                complete = (lastNl == std::string_view::npos) ? 0 : lastNl + 1;
+            }
+            lineNo = parsePatientLines(buffer.data(), buffer.data() + complete, lineNo, loaded, target, symbols);
+            if (complete > 0) mark = parseJournalMark(std::string_view(buffer.data(), complete)); // останній цілий рядок
+            std::memmove(buffer.data(), buffer.data() + complete, filled - complete);
+            filled -= complete;
+
+            if (atEnd) break;
+            if (filled == buffer.size()) buffer.resize(buffer.size() * 2); // рядок довший за буфер
+        }
+        return mark;
+    }
+
+    // Увесь файл відображено в пам'ять: розбираємо одним проходом без копіювання в буфер
+    static JournalMark readMapped(const std::string& filepath, std::vector<SharedPatient>& loaded,
+        std::pmr::memory_resource* target, SymbolPool& symbols) {
+        const MappedFile file(filepath);
+        loaded.reserve(countRecords(file.begin(), file.end()));
+        parsePatientLines(file.begin(), file.end(), 1, loaded, target, symbols);
+        return parseJournalMark(std::string_view(file.begin(), file.size()));
+    }
+
+    // Файл ділиться на threads частин по межах рядків; кожна частина розбирається на своєму
+    // потоці у власний вектор, потім вектори зшиваються у вихідному порядку (лише переміщення
+    // вказівників). При помилці частина розбирається повторно з правильним номером рядка.
+    // Ресурси pmr зазвичай не потокобезпечні: якщо target — не звичайна купа, кожна частина
+    // розбирається у власну арену (додається в arenasOut і живе разом із пацієнтами)
+    static JournalMark readParallel(const std::string& filepath, std::vector<SharedPatient>& loaded,
+        unsigned threads, std::pmr::memory_resource* target, SymbolPool& symbols, ArenaList& arenasOut) {
+        constexpr std::size_t kMinChunkBytes = 1 << 20; // дрібніші частини не окупають потік
+
+        const MappedFile file(filepath);
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        const std::size_t byBytes = file.size() / kMinChunkBytes;
+        const std::size_t chunks = std::max<std::size_t>(1, std::min<std::size_t>(threads, byBytes));
+
+        std::vector<const char*> bounds{ file.begin() };
+        for (std::size_t c = 1; c < chunks; ++c) {
+            const char* cut = std::max(bounds.back(), file.begin() + file.size() * c / chunks);
+            const char* nl = static_cast<const char*>(std::memchr(cut, '\n', static_cast<std::size_t>(file.end() - cut)));
+            bounds.push_back(nl ? nl + 1 : file.end());
+        }
+        bounds.push_back(file.end());
+
+        std::vector<std::pmr::memory_resource*> chunkTargets(chunks, target);
+        if (target != std::pmr::new_delete_resource())
+            for (auto& chunkTarget : chunkTargets) chunkTarget = newArena(arenasOut);
+
+        // Кожна частина інтернує поля у власний пул — без спільного м'ютекса між потоками;
+        // після join словники зливаються в symbols один раз (оголошені ДО parts — переживають записи)
+        std::vector<std::unique_ptr<SymbolPool>> chunkPools(chunks);
+        for (auto& pool : chunkPools) pool = std::make_unique<SymbolPool>();
+        std::vector<std::vector<SharedPatient>> parts(chunks);
+        std::vector<std::exception_ptr> errors(chunks);
+        const auto runChunks = [&](auto&& work) {
+            std::vector<std::thread> workers;
+            workers.reserve(chunks - 1);
+            const auto guarded = [&](std::size_t c) {
+                try { work(c); }
+                catch (...) { errors[c] = std::current_exception(); }
+            };
+            for (std::size_t c = 1; c < chunks; ++c) workers.emplace_back(guarded, c);
+            guarded(0); // перша частина — на поточному потоці
+            for (auto& w : workers) w.join();
+        };
+        runChunks([&](std::size_t c) {
+            parts[c].reserve(countRecords(bounds[c], bounds[c + 1]));
+            parsePatientLines(bounds[c], bounds[c + 1], 1, parts[c], chunkTargets[c], *chunkPools[c]);
+        });
+
+        for (std::size_t c = 0; c < chunks; ++c) {
+            if (!errors[c]) continue;
+            // Повторний розбір лише дає помилці правильний номер рядка; якщо він удався
+            // (збій не в даних, наприклад bad_alloc), кидаємо початкову помилку
+            if (c > 0) {
+                const auto linesBefore = std::count(file.begin(), bounds[c], '\n');
+                std::vector<SharedPatient> scratch;
+                SymbolPool scratchPool;
+                parsePatientLines(bounds[c], bounds[c + 1], static_cast<std::size_t>(linesBefore) + 1, scratch,
+                    std::pmr::new_delete_resource(), scratchPool);
+            }
+            std::rethrow_exception(errors[c]);
+        }
+
+        std::vector<std::vector<SymbolPool::Id>> remaps(chunks);
+        for (std::size_t c = 0; c < chunks; ++c) remaps[c] = chunkPools[c]->mergeInto(symbols);
+        runChunks([&](std::size_t c) {
+            // Записи ще нікому не видані, а самі об'єкти створені неконстантними
+            for (const auto& p : parts[c]) const_cast<Patient&>(*p).remapSymbols(symbols, remaps[c]);
+        });
+        for (const auto& error : errors)
+            if (error) std::rethrow_exception(error);
+
+        std::size_t total = 0;
+        for (const auto& part : parts) total += part.size();
+        loaded.reserve(total);
+        for (auto& part : parts)
+            for (auto& p : part) loaded.push_back(std::move(p));
+        return parseJournalMark(std::string_view(file.begin(), file.size()));
+    }
+};
+
+// ===========================
+// ColumnarPatientStore: необов'язкове колонкове сховище (struct-of-arrays)
+// Вік і тег типу — ті самі PatientColumns, що й у Polyclinic (рядок сховища = слот), тож
+// фільтри й агрегати йдуть тими самими SIMD-ядрами; рядки лежать в одному пулі байтів,
+// а записи зберігають лише номери рядків у пулі.
+// Це окремий незмінний знімок для аналітики, а не режим зберігання самої Polyclinic: клініка
+// вже тримає вік і тип у тих самих колонках (Polyclinic::count / sumAges / histogram / filter),
+// а її записи мають лишатися спільними об'єктами Patient для copy-on-write і PatientId.
+// Після змін у клініці сховище будується заново.
+// Інтерфейс Patient/ChildPatient/ElderPatient доступний через легкі подання PatientView
+// ===========================
+class ColumnarPatientStore;
+
+class PatientView {
+private:
+    const ColumnarPatientStore* store;
+    std::size_t row;
+
+public:
+    PatientView(const ColumnarPatientStore& store, std::size_t row) : store(&store), row(row) {}
+
+    PatientType type() const;
+    int getAge() const;
+    std::string_view getName() const;
+    std::string_view getDisease() const;
+    std::string_view getParentContact() const;     // лише Child, інакше порожньо
+    std::string_view getAllergies() const;         // лише Elder, інакше порожньо
+    std::string_view getContraindications() const; // лише Elder, інакше порожньо
+
+    // Як ChildPatient::needParentalPermission (для інших типів — false)
+    bool needParentalPermission() const { return type() == PatientType::Child && getAge() < 18; }
+
+    // Повноцінний об'єкт (наприклад, щоб додати в Polyclinic або вивести printInfo). Поля
+    // інтернуються в pool; без нього — у пул сховища (тоді об'єкт не має пережити сховище)
+    PatientPtr materialize(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
+    PatientPtr materialize(std::pmr::memory_resource* resource, SymbolPool& pool) const {
+        return type() == PatientType::Elder
+            ? makePatient(resource, pool, type(), getName(), getAge(), getDisease(), getAllergies(), getContraindications())
+            : makePatient(resource, pool, type(), getName(), getAge(), getDisease(), getParentContact());
+    }
+};
+
+class ColumnarPatientStore {
+private:
+    // Текстові поля запису: Extra1 — parentContact (Child) або allergies (Elder),
+    // Extra2 — contraindications (Elder)
+    enum Field { Name, Disease, Extra1, Extra2, kFieldCount };
+
+    PatientColumns columns;                         // вік і тип за номером рядка
+    std::size_t rows = 0;
+    std::vector<std::uint32_t> fields[kFieldCount]; // номери рядків у пулі
+    std::vector<char> pool;                         // байти всіх рядків підряд
+    std::vector<std::uint64_t> poolOffsets{ 0, 0 }; // рядок i = pool[poolOffsets[i], poolOffsets[i + 1]); 0 — ""
+    std::shared_ptr<SymbolPool> symbols = std::make_shared<SymbolPool>(); // для PatientView::materialize
+
+    // Дописує text у пул (без пошуку повторів: сховище будується один раз і не змінюється)
+    std::uint32_t appendText(std::string_view text) {
+        if (text.empty()) return 0;
+        pool.insert(pool.end(), text.begin(), text.end());
+        poolOffsets.push_back(pool.size());
+        return static_cast<std::uint32_t>(poolOffsets.size() - 2);
+    }
+
+    friend class PatientView;
+    std::string_view text(Field field, std::size_t row) const {
+        const std::uint32_t id = fields[field][row];
+        return { pool.data() + poolOffsets[id], static_cast<std::size_t>(poolOffsets[id + 1] - poolOffsets[id]) };
+    }
+
+public:
+    ColumnarPatientStore() = default;
+
+    // Колонкова копія пацієнтів поліклініки
+    explicit ColumnarPatientStore(const Polyclinic& clinic) {
+        const auto n = static_cast<std::size_t>(clinic.getPatientsCount());
+        reserve(n);
+        for (std::size_t i = 0; i < n; ++i) add(*clinic.getPatientPtr(i));
+    }
+
+    void reserve(std::size_t n) {
+        for (auto& column : fields) column.reserve(n);
     }
-};
 
-// ===========================
-// ПОХІДНИЙ 2: ElderPatient
-// Додаткові поля: алергії, протипоказання
-// п.8: власна реалізація toLine()
-// ===========================
-class ElderPatient : public Patient {
-private:
-    std::string allergies;
-    std::string contraindications;
+    void add(const Patient& p) {
+        columns.insert(static_cast<std::uint32_t>(rows++), p.type(), p.getAge());
+        fields[Name].push_back(appendText(p.getName()));
+        fields[Disease].push_back(appendText(p.getDisease()));
+        std::string_view extra1, extra2;
+        if (p.type() == PatientType::Child) {
+            extra1 = static_cast<const ChildPatient&>(p).getParentContact();
+        }
+        else if (p.type() == PatientType::Elder) {
+            const auto& elder = static_cast<const ElderPatient&>(p);
+            extra1 = elder.getAllergies();
+            extra2 = elder.getContraindications();
+        }
+        fields[Extra1].push_back(appendText(extra1));
+        fields[Extra2].push_back(appendText(extra2));
+    }
 
-public:
-    ElderPatient() : Patient(), allergies("Немає"), contraindications("Немає") {}
-    ElderPatient(std::string name, int age, std::string disease,
-        std::string allergies, std::string contraindications)
-        : Patient(std::move(name), age, std::move(disease)),
-        allergies(std::move(allergies)),
-        contraindications(std::move(contraindications)) {
+    std::size_t size() const { return rows; }
+    PatientView operator[](std::size_t row) const { return PatientView(*this, row); }
+
+    // Агрегати за колонками віку й типу (SIMD, як Polyclinic::count / sumAges / histogram)
+    std::size_t count(const ColumnFilter& where) const { return columns.count(where); }
+    std::int64_t sumAges(const ColumnFilter& where) const { return columns.sumAges(where); }
+    std::array<std::size_t, 3> histogram(const ColumnFilter& where) const { return columns.histogram(where); }
+
+    // Номери рядків, що проходять where
+    std::vector<std::size_t> filter(const ColumnFilter& where) const {
+        std::vector<std::size_t> found;
+        columns.forEachMatch(where, [&](std::uint32_t row) { found.push_back(row); });
+        return found;
     }
 
-    std::unique_ptr<Patient> clone() const override {
-        return std::make_unique<ElderPatient>(*this);
+    // pred(age, type) — довільна умова по колонках (без SIMD)
+    template <class Pred>
+    std::size_t countWhere(Pred pred) const {
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < rows; ++i) count += pred(ageAt(i), typeAt(i)) ? 1 : 0;
+        return count;
     }
 
-    void printMedicalWarnings() const {
-        std::cout << "  Алергії: " << allergies
-            << " | Протипоказання: " << contraindications << "\n";
+    template <class Pred>
+    std::vector<std::size_t> filterWhere(Pred pred) const {
+        std::vector<std::size_t> found;
+        for (std::size_t i = 0; i < rows; ++i)
+            if (pred(ageAt(i), typeAt(i))) found.push_back(i);
+        return found;
     }
 
-    void printInfo() const override {
-        std::cout << "Літній пацієнт: " << getName()
-            << ", вік: " << getAge()
-            << ", діагноз: " << getDisease() << "\n";
-        printMedicalWarnings();
+    std::size_t countOlderThan(int age) const {
+        if (age == std::numeric_limits<int>::max()) return 0;
+        return count(ColumnFilter{}.ages(age + 1, std::numeric_limits<int>::max()));
     }
 
-    std::string toLine() const override {
-        return std::string("Elder") + "|" + getName() + "|" + std::to_string(getAge())
-            + "|" + getDisease() + "|" + allergies + "|" + contraindications;
+    // Середній вік пацієнтів заданого типу (0, якщо таких немає)
+    double averageAge(PatientType type) const {
+        const std::size_t n = count(ColumnFilter::of(type));
+        return n ? static_cast<double>(sumAges(ColumnFilter::of(type))) / static_cast<double>(n) : 0.0;
     }
+
+private:
+    int ageAt(std::size_t row) const { return columns.ageAt(static_cast<std::uint32_t>(row)); }
+    PatientType typeAt(std::size_t row) const { return columns.typeAt(static_cast<std::uint32_t>(row)); }
 };
 
+inline PatientType PatientView::type() const { return store->typeAt(row); }
+inline int PatientView::getAge() const { return store->ageAt(row); }
+inline std::string_view PatientView::getName() const { return store->text(ColumnarPatientStore::Name, row); }
+inline std::string_view PatientView::getDisease() const { return store->text(ColumnarPatientStore::Disease, row); }
+inline std::string_view PatientView::getParentContact() const {
+    return type() == PatientType::Child ? store->text(ColumnarPatientStore::Extra1, row) : std::string_view();
+}
+inline std::string_view PatientView::getAllergies() const {
+    return type() == PatientType::Elder ? store->text(ColumnarPatientStore::Extra1, row) : std::string_view();
+}
+inline std::string_view PatientView::getContraindications() const {
+    return type() == PatientType::Elder ? store->text(ColumnarPatientStore::Extra2, row) : std::string_view();
+}
+inline PatientPtr PatientView::materialize(std::pmr::memory_resource* resource) const {
+    return materialize(resource, *store->symbols);
+}
+
 // ===========================
-// Polyclinic: зберігає ПОЛІМОРФНИХ пацієнтів
-// (std::unique_ptr<Patient>) + глибоке копіювання через clone()
-// п.8: saveToFile() — «1 пацієнт = 1 рядок»
-// п.9: кидання виключень у помилкових ситуаціях
+// PatientRecordStore: закрита ієрархія без віртуальної диспетчеризації
+// Записи лежать прямо у векторі std::variant<Patient, ChildPatient, ElderPatient> — без
+// окремої алокації на запис. Виклики йдуть через std::visit із кваліфікованими викликами
+// T::printInfo / T::serializeTo: точний тип відомий компілятору, тож vtable не потрібна
+// і тіло методу можна вбудувати в цикл
 // ===========================
-class Polyclinic {
-private:
-    std::string name;
-    std::string address;
-    int doctorsCount{};
-    std::vector<std::unique_ptr<Patient>> patients; // гетерогенний список (різні підтипи)
-
-public:
-    // Конструктори
-    Polyclinic() : name("Без назви"), address("Невідомо"), doctorsCount(0) {}
+using PatientRecord = std::variant<Patient, ChildPatient, ElderPatient>;
 
-    Polyclinic(std::string name, std::string address, int doctors)
-        : name(std::move(name)), address(std::move(address)),
-        doctorsCount(doctors < 0 ? 0 : doctors) {
+// Копія p точного підтипу; інтерновані поля — у пулі p (пул має пережити запис)
+inline PatientRecord makeRecord(const Patient& p) {
+    switch (p.type()) {
+    case PatientType::Child: return static_cast<const ChildPatient&>(p);
+    case PatientType::Elder: return static_cast<const ElderPatient&>(p);
+    default: return p;
     }
+}
 
-    // Глибоке копіювання: клонування кожного пацієнта
-    Polyclinic(const Polyclinic& other)
-        : name(other.name), address(other.address), doctorsCount(other.doctorsCount) {
-        patients.reserve(other.patients.size());
-        for (const auto& p : other.patients) patients.push_back(p->clone());
+// Те саме з інтернованими полями в pool
+inline PatientRecord makeRecord(const Patient& p, SymbolPool& pool) {
+    const Patient::allocator_type alloc;
+    switch (p.type()) {
+    case PatientType::Child: return PatientRecord(std::in_place_type<ChildPatient>, static_cast<const ChildPatient&>(p), pool, alloc);
+    case PatientType::Elder: return PatientRecord(std::in_place_type<ElderPatient>, static_cast<const ElderPatient&>(p), pool, alloc);
+    default: return PatientRecord(std::in_place_type<Patient>, p, pool, alloc);
     }
+}
 
-    ~Polyclinic() = default; // unique_ptr автоматично звільнить пам'ять
+// Записи тримають інтерновані поля у власному пулі сховища (спільному для його копій),
+// тож сховище не залежить від часу життя клініки, з якої його побудовано
+class PatientRecordStore {
+private:
+    std::shared_ptr<SymbolPool> symbols = std::make_shared<SymbolPool>();
+    std::vector<PatientRecord> records;
 
-    void printInfo() const {
-        std::cout << "Поліклініка '" << name << "' за адресою " << address
-            << " | лікарів: " << doctorsCount
-            << " | пацієнтів: " << getPatientsCount() << "\n";
-    }
+public:
+    PatientRecordStore() = default;
 
-    void printAllPatients() const {
-        if (patients.empty()) {
-            std::cout << "  [пацієнтів немає]\n";
-            return;
+    // Номери пулу клініки переводяться в пул сховища один раз (mergeInto), а не хешуванням полів кожного запису
+    explicit PatientRecordStore(const Polyclinic& clinic) {
+        const auto n = static_cast<std::size_t>(clinic.getPatientsCount());
+        records.reserve(n);
+        const SymbolPool* from = nullptr;
+        std::vector<SymbolPool::Id> remap;
+        for (std::size_t i = 0; i < n; ++i) {
+            const Patient& p = *clinic.getPatientPtr(i);
+            if (&p.symbolPool() != from) { // влиті з інших клінік записи лежать суцільними діапазонами
+                from = &p.symbolPool();
+                remap = from->mergeInto(*symbols);
+            }
+            records.push_back(makeRecord(p));
+            std::visit([&](auto& r) { r.remapSymbols(*symbols, remap); }, records.back());
         }
-        for (const auto& p : patients) p->printInfo(); // поліморфний виклик
     }
 
-    // Додавання / видалення пацієнтів
-    void addPatient(const Patient& p) { patients.push_back(p.clone()); }
-
-    void addChild(const std::string& pname, int age, const std::string& disease,
-        const std::string& parentContact) {
-        ChildPatient c{ pname, age, disease, parentContact };
-        addPatient(c);
+    void add(PatientRecord record) {
+        std::visit([&](auto& r) { r.rebindSymbols(*symbols); }, record);
+        records.push_back(std::move(record));
     }
+    void add(const Patient& p) { records.push_back(makeRecord(p, *symbols)); }
 
-    void addElder(const std::string& pname, int age, const std::string& disease,
-        const std::string& allergies, const std::string& contraindications) {
-        ElderPatient e{ pname, age, disease, allergies, contraindications };
-        addPatient(e);
-    }
+    std::size_t size() const { return records.size(); }
+    const PatientRecord& operator[](std::size_t index) const { return records[index]; }
 
-    // п.9: кидати виключення при видаленні з порожньої клініки
-    void removeLastPatient() {
-        if (patients.empty()) throw EmptyClinicError("Немає пацієнтів для видалення");
-        patients.pop_back();
+    // Загальний доступ до полів базового класу (гетери Patient невіртуальні)
+    static const Patient& base(const PatientRecord& record) {
+        return std::visit([](const auto& p) -> const Patient& { return p; }, record);
     }
 
-    // п.9: кидати виключення при неправильному індексі
-    void removePatientByIndex(size_t index) {
-        if (index >= patients.size()) throw PatientIndexError("Індекс за межами діапазону");
-        patients.erase(patients.begin() + static_cast<std::ptrdiff_t>(index));
+    void printAll() const {
+        if (records.empty()) {
+            std::cout << "  [пацієнтів немає]\n";
+            return;
+        }
+        for (const auto& record : records)
+            std::visit([](const auto& p) {
+                using T = std::decay_t<decltype(p)>;
+                p.T::printInfo(); // невіртуальний виклик точного типу
+            }, record);
     }
 
-    int getPatientsCount() const { return static_cast<int>(patients.size()); }
-
-    const Patient* getPatientPtr(size_t index) const {
-        if (index < patients.size()) return patients[index].get();
-        return nullptr;
+    // Рядки формату saveToFile для всіх записів
+    void serializeTo(SerializeBuffer& out) const {
+        for (const auto& record : records) {
+            std::visit([&out](const auto& p) {
+                using T = std::decay_t<decltype(p)>;
+                p.T::serializeTo(out);
+            }, record);
+            out.append('\n');
+        }
     }
 
-    // Оператори (логіка як раніше; видалення може кинути EmptyClinicError)
-    Polyclinic& operator++() { addPatient(Patient{}); return *this; }
-    Polyclinic operator++(int) { Polyclinic t(*this); ++(*this); return t; }
-    Polyclinic& operator--() { removeLastPatient(); return *this; }
-    Polyclinic operator--(int) { Polyclinic t(*this); --(*this); return t; }
-
-    Polyclinic operator+(const Polyclinic& other) const {
-        Polyclinic merged(*this);
-        merged.name = this->name + " + " + other.name;
-        merged.doctorsCount = this->doctorsCount + other.doctorsCount;
-        merged.patients.reserve(this->patients.size() + other.patients.size());
-        for (const auto& p : other.patients) merged.patients.push_back(p->clone());
-        return merged;
+    // Повний запис у форматі saveToFile (кидає FileSaveError), блоками по ~1 МіБ
+    void saveToFile(const std::string& filepath) const {
+        constexpr std::size_t kFlushBlockSize = 1 << 20;
+        std::ofstream ofs(filepath, std::ios::binary);
+        if (!ofs) throw FileSaveError("Не вдається відкрити файл: " + filepath);
+        SerializeBuffer out(kFlushBlockSize + 4096);
+        for (const auto& record : records) {
+            std::visit([&out](const auto& p) {
+                using T = std::decay_t<decltype(p)>;
+                p.T::serializeTo(out);
+            }, record);
+            out.append('\n');
+            if (out.size() >= kFlushBlockSize) {
+                ofs.write(out.view().data(), static_cast<std::streamsize>(out.size()));
+                out.clear();
+            }
+        }
+        ofs.write(out.view().data(), static_cast<std::streamsize>(out.size()));
+        if (!ofs.flush()) throw FileSaveError("Помилка запису файлу: " + filepath);
     }
 
-    Polyclinic& operator+=(const Polyclinic& other) {
-        this->name = this->name + " + " + other.name;
-        this->doctorsCount += other.doctorsCount;
-        patients.reserve(patients.size() + other.patients.size());
-        for (const auto& p : other.patients) patients.push_back(p->clone());
-        return *this;
+    // pred(const T&) отримує точний тип запису (ChildPatient, ElderPatient або Patient)
+    template <class Pred>
+    std::size_t countIf(Pred pred) const {
+        std::size_t count = 0;
+        for (const auto& record : records) count += std::visit(pred, record) ? 1 : 0;
+        return count;
     }
 
-    bool operator==(const Polyclinic& other) const {
-        return getPatientsCount() == other.getPatientsCount();
+    // Окремий об'єкт запису index з інтернованими полями в pool (наприклад, пулі клініки)
+    PatientPtr materialize(std::size_t index, std::pmr::memory_resource* resource, SymbolPool& pool) const {
+        return std::visit([&](const auto& p) {
+            using T = std::decay_t<decltype(p)>;
+            return allocatePatient<T>(resource, p, pool);
+        }, records[index]);
     }
-    bool operator!=(const Polyclinic& other) const { return !(*this == other); }
 
-    // п.8 + п.9: збереження у файл (кидає FileSaveError при невдачі)
-    void saveToFile(const std::string& filepath) const {
-        std::ofstream ofs(filepath);
-        if (!ofs) throw FileSaveError("Не вдається відкрити файл: " + filepath);
-        for (const auto& p : patients) ofs << p->toLine() << '\n'; // поліморфний виклик
+    // Те саме в пулі сховища (тоді об'єкт не має пережити сховище)
+    PatientPtr materialize(std::size_t index,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const {
+        return materialize(index, resource, *symbols);
     }
 };
 
@@ -280,15 +4869,15 @@ public:
     // Адміністративні дії
     void addDefaultPatient(Polyclinic& clinic) const { clinic.addPatient(Patient{}); }
     void addChildPatient(Polyclinic& clinic,
-        const std::string& name, int age,
-        const std::string& disease, const std::string& parentContact) const {
-        clinic.addChild(name, age, disease, parentContact);
+        std::string_view name, int age,
+        std::string_view disease, std::string_view parentContact) const {
+        clinic.emplacePatient<ChildPatient>(name, age, disease, parentContact);
     }
     void addElderPatient(Polyclinic& clinic,
-        const std::string& name, int age,
-        const std::string& disease,
-        const std::string& allergies, const std::string& contraindications) const {
-        clinic.addElder(name, age, disease, allergies, contraindications);
+        std::string_view name, int age,
+        std::string_view disease,
+        std::string_view allergies, std::string_view contraindications) const {
+        clinic.emplacePatient<ElderPatient>(name, age, disease, allergies, contraindications);
     }
     // п.9: при неправильному індексі проброситься PatientIndexError
     void removeAt(Polyclinic& clinic, size_t index) const {
@@ -298,10 +4887,890 @@ public:
 
 class Manager : public RoleUser, public RoleAdmin {};
 
+// ===========================
+// Бенчмарки (запуск: Polyclinic.exe --bench [кількість пацієнтів])
+// ===========================
+using BenchClock = std::chrono::steady_clock;
+
+// Найкращий час із кількох повторів, мс
+template <class F>
+double benchBestMs(int repeats, F&& body) {
+    double best = 0;
+    for (int r = 0; r < repeats; ++r) {
+        const auto t0 = BenchClock::now();
+        body();
+        const double ms = std::chrono::duration<double, std::milli>(BenchClock::now() - t0).count();
+        if (r == 0 || ms < best) best = ms;
+    }
+    return best;
+}
+
+// Детермінована суміш Patient/Child/Elder з кириличними полями
+Polyclinic makeSyntheticClinic(std::size_t count) {
+    static const char* const names[] = { "Олексій", "Марта", "Петро", "Ірина", "Андрій", "Оксана", "Юрій" };
+    static const char* const diseases[] = { "Грип", "Діабет", "Застуда", "Травма", "Серцеве захворювання" };
+    Polyclinic clinic("Синтетична поліклініка", "вул. Тестова, 1", 10);
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::string pname = std::string(names[i % 7]) + " " + std::to_string(i);
+        const char* disease = diseases[i % 5];
+        switch (i % 3) {
+        case 0: clinic.addPatient(Patient{ pname, static_cast<int>(18 + i % 47), disease }); break;
+        case 1: clinic.addChild(pname, static_cast<int>(i % 18), disease, "Мама: +380501112233"); break;
+        default: clinic.addElder(pname, static_cast<int>(65 + i % 30), disease, "Пеніцилін", "Немає"); break;
+        }
+    }
+    return clinic;
+}
+
+void benchLoadModes(std::size_t count) {
+    const std::string path = "bench_patients.txt";
+    makeSyntheticClinic(count).saveToFile(path);
+    std::ifstream probe(path, std::ios::binary | std::ios::ate);
+    const double mb = static_cast<double>(probe.tellg()) / (1024.0 * 1024.0);
+
+    std::cout << "[loadFromFile] " << count << " пацієнтів, " << mb << " МіБ (теплий кеш ОС)\n";
+    const struct { const char* label; LoadMode mode; } modes[] = {
+        { "Stream (ifstream, буфер 1 МіБ)", LoadMode::Stream },
+        { "Mapped (mmap/MapViewOfFile)   ", LoadMode::Mapped },
+        { "Parallel (mmap, усі ядра)     ", LoadMode::Parallel },
+    };
+    for (const auto& m : modes) {
+        Polyclinic clinic;
+        const double ms = benchBestMs(3, [&] { clinic.loadFromFile(path, m.mode); });
+        std::cout << "  " << m.label << ": " << ms << " мс, " << mb / (ms / 1000.0) << " МіБ/с\n";
+    }
+    std::remove(path.c_str());
+}
+
+// Виписка з середини списку: removePatientByIndex (зсув хвоста) проти removePatient(PatientId)
+void benchDischarge(std::size_t count) {
+    const std::size_t removals = std::min<std::size_t>(1000, count / 2);
+    std::cout << "[discharge] " << removals << " виписок із середини клініки з " << count << " пацієнтів\n";
+    Polyclinic byIndex = makeSyntheticClinic(count); // окремі клініки: копія спільна до першої зміни
+    const auto t0 = BenchClock::now();
+    for (std::size_t r = 0; r < removals; ++r)
+        byIndex.removePatientByIndex((r * 7919) % static_cast<std::size_t>(byIndex.getPatientsCount()));
+    const double indexMs = std::chrono::duration<double, std::milli>(BenchClock::now() - t0).count();
+
+    Polyclinic byId = makeSyntheticClinic(count);
+    std::vector<PatientId> ids;
+    for (std::size_t r = 0; r < removals; ++r) ids.push_back(byId.getPatientId(count / 4 + r * 2));
+    const auto t1 = BenchClock::now();
+    for (const PatientId id : ids) byId.removePatient(id);
+    const double idMs = std::chrono::duration<double, std::milli>(BenchClock::now() - t1).count();
+
+    std::cout << "  за індексом: " << indexMs * 1000 / static_cast<double>(removals) << " мкс/виписка, за PatientId: "
+        << idMs * 1000 / static_cast<double>(removals) << " мкс/виписка\n";
+}
+
+// Copy-on-write: копія клініки, перша зміна копії (відокремлення таблиці) і постфіксний ++
+void benchCopyOnWrite(std::size_t count) {
+    Polyclinic clinic = makeSyntheticClinic(count);
+    std::cout << "[copy-on-write] клініка з " << count << " пацієнтів, мс\n";
+    std::unique_ptr<Polyclinic> copy;
+    const double copyMs = benchBestMs(3, [&] { copy = std::make_unique<Polyclinic>(clinic); });
+    const double detachMs = benchBestMs(3, [&] {
+        Polyclinic report(clinic);
+        report.removeLastPatient();
+    });
+    // Друга зміна вже не копіює: різниця з першою — ціна відокремлення таблиці з індексами
+    Polyclinic detached(clinic);
+    detached.removeLastPatient();
+    const double nextMs = benchBestMs(3, [&] { detached.removeLastPatient(); });
+    const double postfixMs = benchBestMs(3, [&] { clinic++; });
+    std::cout << "  копія: " << copyMs << "; копія + перша зміна: " << detachMs << " (" << detachMs * 1e6 / count
+              << " нс/запис); наступна зміна: " << nextMs << "; clinic++: " << postfixMs << "\n";
+}
+
+// Регіональне зведення з районних клінік: += копії (спільні записи) проти += std::move
+void benchMerge(std::size_t count) {
+    const std::size_t districts = 500;
+    std::cout << "[merge] " << districts << " районних клінік, разом " << count << " пацієнтів, мс\n";
+    const struct { const char* label; bool move; } modes[] = { { "+= district           ", false }, { "+= std::move(district)", true } };
+    for (const auto& m : modes) {
+        std::vector<Polyclinic> parts;
+        parts.reserve(districts);
+        for (std::size_t d = 0; d < districts; ++d) parts.push_back(makeSyntheticClinic(count / districts));
+        Polyclinic region("Регіон", "вул. Обласна, 1", 0);
+        const auto t0 = BenchClock::now();
+        for (auto& part : parts) {
+            if (m.move) region += std::move(part);
+            else region += part;
+        }
+        const double ms = std::chrono::duration<double, std::milli>(BenchClock::now() - t0).count();
+        std::cout << "  " << m.label << ": " << ms << " (" << region.getPatientsCount() << " пацієнтів)\n";
+    }
+}
+
+// Потік прийомів: тимчасовий об'єкт + clone() (addPatient(const Patient&)) проти emplacePatient
+void benchAdmission(std::size_t count) {
+    std::vector<std::string> names(count);
+    for (std::size_t i = 0; i < count; ++i) names[i] = "Пацієнт прийому № " + std::to_string(i);
+    std::cout << "[admission] " << count << " прийомів (Child/Elder), нс на прийом\n";
+    const double tempMs = benchBestMs(3, [&] {
+        Polyclinic clinic;
+        for (std::size_t i = 0; i < count; ++i) {
+            if (i % 2) clinic.addPatient(ChildPatient{ names[i], 7, "Застуда", "Мама: +380501112233" });
+            else clinic.addPatient(ElderPatient{ names[i], 70, "Грип", "Пеніцилін", "Немає" });
+        }
+    });
+    const double emplaceMs = benchBestMs(3, [&] {
+        Polyclinic clinic;
+        for (std::size_t i = 0; i < count; ++i) {
+            if (i % 2) clinic.emplacePatient<ChildPatient>(names[i], 7, "Застуда", "Мама: +380501112233");
+            else clinic.emplacePatient<ElderPatient>(names[i], 70, "Грип", "Пеніцилін", "Немає");
+        }
+    });
+    const auto perInsert = [count](double ms) { return ms * 1e6 / static_cast<double>(count); };
+    std::cout << "  тимчасовий + clone: " << perInsert(tempMs) << ", emplacePatient: " << perInsert(emplaceMs) << "\n";
+}
+
+// Місячна чистка: видалення кожного десятого пацієнта по одному (removePatientByIndex, O(n) кожне)
+// проти одного проходу removeIf. Старий шлях квадратичний, тож клініка менша.
+// Обидва варіанти змінюють копію спільної клініки (відділення таблиці враховано в обох)
+void benchPurge(std::size_t count) {
+    const std::size_t n = std::min<std::size_t>(count, 100000);
+    const auto discharged = [](const Patient& p) { return p.getAge() % 10 == 3; };
+    const Polyclinic source = makeSyntheticClinic(n);
+    std::size_t removed = 0;
+    const double oneByOneMs = benchBestMs(1, [&] {
+        Polyclinic clinic = source;
+        for (std::size_t i = source.getPatientsCount(); i-- > 0;) {
+            if (discharged(*clinic.getPatientPtr(i))) clinic.removePatientByIndex(i);
+        }
+    });
+    const double bulkMs = benchBestMs(3, [&] {
+        Polyclinic clinic = source;
+        removed = clinic.removeIf(discharged);
+    });
+    std::cout << "[purge] " << n << " пацієнтів, виписано " << removed << "\n";
+    std::cout << "  по одному: " << oneByOneMs << " мс, removeIf: " << bulkMs << " мс\n";
+}
+
+// Затримка кожного окремого прийому в клініку, що росте до count пацієнтів: перцентилі й максимум.
+// Зі сторінками фіксованого розміру існуючі записи не переносяться, тож хвіст не залежить від розміру
+void benchInsertLatency(std::size_t count) {
+    std::vector<std::string> names(count);
+    for (std::size_t i = 0; i < count; ++i) names[i] = "Пацієнт " + std::to_string(i);
+    std::vector<double> latencyNs(count);
+    Polyclinic clinic("Латентність", "вул. Тестова, 1", 1, PatientMemory::Arena);
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto t0 = BenchClock::now();
+        clinic.emplacePatient<ChildPatient>(names[i], 7, "Застуда", "Мама: +380501112233");
+        latencyNs[i] = std::chrono::duration<double, std::nano>(BenchClock::now() - t0).count();
+    }
+    std::sort(latencyNs.begin(), latencyNs.end());
+    const auto percentile = [&](double q) { return latencyNs[static_cast<std::size_t>(q * static_cast<double>(count - 1))]; };
+    std::cout << "[insert-latency] " << count << " прийомів, нс: p50 " << percentile(0.5)
+        << ", p99.9 " << percentile(0.999) << ", p99.99 " << percentile(0.9999)
+        << ", max " << latencyNs.back() << "\n";
+}
+
+// Пошук на рецепції: лінійний прохід getPatientPtr(i) проти хеш-індексу findByName / findByIdentity
+void benchNameLookup(std::size_t count) {
+    const Polyclinic clinic = makeSyntheticClinic(count);
+    constexpr std::size_t kScans = 20;
+    constexpr std::size_t kLookups = 100000;
+    std::vector<std::string> wanted;
+    for (std::size_t i = 0; i < kLookups; ++i) {
+        wanted.emplace_back(clinic.getPatientPtr((i * 7919) % count)->getName());
+    }
+    std::size_t hits = 0;
+    const double scanMs = benchBestMs(1, [&] {
+        for (std::size_t i = 0; i < kScans; ++i) {
+            for (int j = 0; j < clinic.getPatientsCount(); ++j) {
+                if (clinic.getPatientPtr(j)->getName() == wanted[i]) { ++hits; break; }
+            }
+        }
+    });
+    const double indexMs = benchBestMs(3, [&] {
+        for (const auto& w : wanted) hits += clinic.findByName(w).size();
+    });
+    const double identityMs = benchBestMs(3, [&] {
+        for (const auto& w : wanted) hits += clinic.findByIdentity(w, 40).generation != 0 ? 1 : 0;
+    });
+    std::cout << "[name-lookup] " << count << " пацієнтів, мкс на пошук: прохід " << scanMs * 1e3 / kScans
+        << ", findByName " << indexMs * 1e3 / kLookups << ", findByIdentity " << identityMs * 1e3 / kLookups
+        << " (" << hits << ")\n";
+}
+
+// Реєстратура набирає «Олексій Ґ…» по літері: прохід зі згортанням кожного імені проти словника префіксів
+void benchNameSuggest(std::size_t count) {
+    static const char* const firstNames[] = { "Олексій", "Олена", "Іван", "Ірина", "Їжак", "Євген", "Юлія", "Ґлорія" };
+    static const char* const surnames[] = { "Ґонта", "Шевченко", "Коваль", "Бондаренко", "Мельник", "Ткачук", "Олійник" };
+    Polyclinic clinic;
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::string pname = std::string(firstNames[i % 8]) + " " + surnames[(i / 8) % 7] + " " + std::to_string(i);
+        clinic.emplacePatient<Patient>(pname, static_cast<int>(i % 90), "Грип");
+    }
+    const std::string typed = "ОЛЕКСІЙ ҐОНТА 1";
+    std::vector<std::string> keystrokes;
+    for (std::size_t i = 0; i < typed.size();) {
+        std::size_t next = i;
+        decodeUtf8(typed, next);
+        keystrokes.push_back(typed.substr(0, next));
+        i = next;
+    }
+    std::size_t scanned = 0;
+    const double scanMs = benchBestMs(1, [&] {
+        std::string wanted;
+        std::string folded;
+        foldName(keystrokes.back(), wanted, true);
+        for (int j = 0; j < clinic.getPatientsCount(); ++j) {
+            foldName(clinic.getPatientPtr(j)->getName(), folded);
+            scanned += folded.compare(0, wanted.size(), wanted) == 0 ? 1 : 0;
+        }
+    });
+    std::size_t suggested = 0;
+    const double suggestMs = benchBestMs(5, [&] {
+        for (const auto& prefix : keystrokes) suggested += clinic.suggestByName(prefix, 10).size();
+    });
+    std::cout << "[name-suggest] " << count << " пацієнтів: прохід " << scanMs << " мс на літеру (" << scanned
+        << "), suggestByName " << suggestMs * 1e3 / static_cast<double>(keystrokes.size()) << " мкс на літеру ("
+        << suggested << ")\n";
+}
+
+// Звірка записів із паперових форм: ім'я з однією-двома помилками — попарне порівняння з усіма
+// проти fuzzyFind через індекс триграм
+void benchFuzzyName(std::size_t count) {
+    static const char* const firstNames[] = { "Олексій", "Олена", "Іван", "Ірина", "Євген", "Юлія", "Ґлорія", "Оксана" };
+    static const char* const surnames[] = { "Ґонта", "Шевченко", "Коваль", "Бондаренко", "Мельник", "Ткачук", "Олійник" };
+    Polyclinic clinic;
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::string pname = std::string(firstNames[i % 8]) + " " + surnames[(i / 8) % 7] + " " + std::to_string(i);
+        clinic.emplacePatient<Patient>(pname, static_cast<int>(i % 90), "Грип");
+    }
+    std::vector<std::string> misspelled;
+    for (std::size_t i = 0; i < 100; ++i) {
+        const std::size_t at = (i * 7919) % count;
+        std::string pname = std::string(firstNames[at % 8]) + " " + surnames[(at / 8) % 7] + " " + std::to_string(at);
+        pname.erase(2, 2);                   // загублено другу літеру (кирилиця — 2 байти)
+        pname.insert(pname.size() - 1, "0"); // і зайва цифра
+        misspelled.push_back(pname);
+    }
+    std::size_t scanned = 0;
+    const double scanMs = benchBestMs(1, [&] {
+        std::string folded;
+        std::u32string wanted;
+        std::u32string other;
+        foldName(misspelled[0], folded);
+        toCodepoints(folded, wanted);
+        for (int j = 0; j < clinic.getPatientsCount(); ++j) {
+            foldName(clinic.getPatientPtr(j)->getName(), folded);
+            toCodepoints(folded, other);
+            scanned += boundedEditDistance(wanted, other, 2) <= 2 ? 1 : 0;
+        }
+    });
+    std::size_t matched = 0;
+    const double fuzzyMs = benchBestMs(3, [&] {
+        for (const auto& pname : misspelled) matched += clinic.fuzzyFind(pname, 5).size();
+    });
+    std::cout << "[fuzzy-name] " << count << " пацієнтів, мс на запит: прохід " << scanMs << " (" << scanned
+        << "), fuzzyFind " << fuzzyMs / static_cast<double>(misspelled.size()) << " (" << matched << ")\n";
+}
+
+// Побудова індексів імен при завантаженні: вставка по одному запису проти build, а також
+// повне loadSnapshot у нову клініку й повторне в ту саму
+void benchNameIndexLoad(std::size_t count) {
+    static const char* const firstNames[] = { "Олексій", "Олена", "Іван", "Ірина", "Євген", "Юлія", "Ґлорія", "Оксана" };
+    static const char* const surnames[] = { "Ґонта", "Шевченко", "Коваль", "Бондаренко", "Мельник", "Ткачук", "Олійник" };
+    std::vector<std::string> pnames(count);
+    for (std::size_t i = 0; i < count; ++i)
+        pnames[i] = std::string(firstNames[(i * 5) % 8]) + " " + surnames[(i / 8) % 7] + " " + std::to_string(i);
+    std::vector<std::pair<std::uint32_t, std::string_view>> names;
+    for (std::size_t i = 0; i < count; ++i) names.emplace_back(static_cast<std::uint32_t>(i), pnames[i]);
+
+    std::cout << "[name-index-load] " << count << " імен, мс: по одному / build\n";
+    NamePrefixIndex prefix;
+    const double prefixInsertMs = benchBestMs(3, [&] {
+        prefix.clear();
+        for (const auto& [slot, pname] : names) prefix.insert(slot, pname);
+    });
+    const double prefixBuildMs = benchBestMs(3, [&] { prefix.build(names); });
+    TrigramIndex trigrams;
+    const double trigramInsertMs = benchBestMs(3, [&] {
+        trigrams.clear();
+        for (const auto& [slot, pname] : names) trigrams.insert(slot, pname);
+    });
+    const double trigramBuildMs = benchBestMs(3, [&] { trigrams.build(names); });
+    std::cout << "  NamePrefixIndex: " << prefixInsertMs << " / " << prefixBuildMs << "\n";
+    std::cout << "  TrigramIndex:    " << trigramInsertMs << " / " << trigramBuildMs << "\n";
+
+    const std::string snapPath = "bench_names.snap";
+    Polyclinic source;
+    for (const auto& pname : pnames) source.emplacePatient<Patient>(pname, 40, "Грип");
+    source.saveSnapshot(snapPath, Durability::None);
+    const double freshMs = benchBestMs(3, [&] {
+        Polyclinic clinic;
+        clinic.loadSnapshot(snapPath);
+    });
+    Polyclinic clinic;
+    const double reloadMs = benchBestMs(3, [&] { clinic.loadSnapshot(snapPath); });
+    std::size_t suggested = 0;
+    const double firstSuggestMs = benchBestMs(3, [&] {
+        clinic.loadSnapshot(snapPath);
+        suggested = clinic.suggestByName("оле").size();
+    }) - reloadMs;
+    std::cout << "  loadSnapshot: у нову клініку " << freshMs << ", повторно " << reloadMs << "\n";
+    const double firstFuzzyMs = benchBestMs(3, [&] {
+        clinic.loadSnapshot(snapPath);
+        suggested = clinic.fuzzyFind("Олексій Ґонта 17", 10).size();
+    }) - reloadMs;
+    std::cout << "  перший suggestByName (побудова індексу): " << firstSuggestMs << ", перший fuzzyFind: " << firstFuzzyMs
+              << " (знайдено " << suggested << ")\n";
+    std::remove(snapPath.c_str());
+}
+
+// Звіти вакцинації: вік 60–75 і неповнолітні — повний прохід проти індексу віку
+void benchAgeQueries(std::size_t count) {
+    const Polyclinic clinic = makeSyntheticClinic(count);
+    std::size_t scanned = 0;
+    std::size_t indexed = 0;
+    const double scanMs = benchBestMs(3, [&] {
+        scanned = 0;
+        for (int i = 0; i < clinic.getPatientsCount(); ++i) {
+            const int age = clinic.getPatientPtr(i)->getAge();
+            scanned += (age >= 60 && age <= 75 ? 1 : 0) + (age < 18 ? 1 : 0);
+        }
+    });
+    const double countMs = benchBestMs(3, [&] { indexed = clinic.countByAge(60, 75) + clinic.countByAge(0, 17); });
+    std::size_t visited = 0;
+    const double rangeMs = benchBestMs(3, [&] {
+        visited = 0;
+        clinic.rangeByAge(60, 75, [&](PatientId, const Patient& p) { visited += p.getAge() >= 60 ? 1 : 0; });
+    });
+    std::cout << "[age] " << count << " пацієнтів: прохід " << scanMs << " мс (" << scanned << "), countByAge "
+        << countMs * 1e3 << " мкс (" << indexed << "), rangeByAge 60–75 " << rangeMs << " мс (" << visited << ")\n";
+}
+
+// Запити безпеки ліків: діагноз AND алергія, алергія OR протипоказання — прохід проти індексу термів
+void benchTermQueries(std::size_t count) {
+    static const char* const diseases[] = { "Грип", "Діабет", "Застуда", "Травма", "Серцеве захворювання" };
+    std::vector<std::string> drugs{ "Пеніцилін", "Аспірин" };
+    while (drugs.size() < 200) drugs.push_back("Препарат" + std::to_string(drugs.size()));
+    Polyclinic clinic;
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::string pname = "Пацієнт " + std::to_string(i);
+        const char* disease = diseases[i % 5];
+        if (i % 2) clinic.emplacePatient<ChildPatient>(pname, static_cast<int>(i % 18), disease, "Мама");
+        else clinic.emplacePatient<ElderPatient>(pname, static_cast<int>(65 + i % 30), disease,
+            drugs[(i / 10) % drugs.size()], drugs[(i / 3 + 7) % drugs.size()]);
+    }
+    std::size_t scanned = 0;
+    const double scanMs = benchBestMs(3, [&] {
+        scanned = 0;
+        for (int i = 0; i < clinic.getPatientsCount(); ++i) {
+            const Patient* p = clinic.getPatientPtr(i);
+            if (p->type() != PatientType::Elder || p->getDisease() != "Діабет") continue;
+            scanned += static_cast<const ElderPatient*>(p)->getAllergies() == "Пеніцилін" ? 1 : 0;
+        }
+    });
+    std::size_t both = 0;
+    const double andMs = benchBestMs(5, [&] {
+        both = clinic.findAll({ { TermField::Disease, "діабет" }, { TermField::Allergies, "ПЕНІЦИЛІН" } }).size();
+    });
+    std::size_t either = 0;
+    const double orMs = benchBestMs(5, [&] {
+        either = clinic.findAny({ { TermField::Allergies, "аспірин" }, { TermField::Contraindications, "аспірин" } }).size();
+    });
+    std::cout << "[terms] " << count << " пацієнтів: прохід " << scanMs << " мс (" << scanned << "), AND "
+        << andMs << " мс (" << both << "), OR " << orMs << " мс (" << either << ")\n";
+}
+
+// Купа проти власної арени: масове завантаження, глибока копія і знищення всієї клініки
+void benchArena(std::size_t count) {
+    const std::string path = "bench_patients.txt";
+    makeSyntheticClinic(count).saveToFile(path);
+    std::cout << "[arena] " << count << " пацієнтів: Heap / Arena, мс\n";
+    const struct { const char* label; PatientMemory memory; } modes[] = {
+        { "Heap ", PatientMemory::Heap },
+        { "Arena", PatientMemory::Arena },
+    };
+    for (const auto& m : modes) {
+        double loadMs = 0, copyMs = 0, teardownMs = 0;
+        for (int r = 0; r < 3; ++r) {
+            auto clinic = std::make_unique<Polyclinic>("Арена", "вул. Тестова, 1", 10, m.memory);
+            const double load = benchBestMs(1, [&] { clinic->loadFromFile(path, LoadMode::Mapped); });
+            std::unique_ptr<Polyclinic> copy;
+            const double cloned = benchBestMs(1, [&] { copy = std::make_unique<Polyclinic>(*clinic); });
+            const double teardown = benchBestMs(1, [&] { clinic.reset(); copy.reset(); }) / 2;
+            if (r == 0 || load < loadMs) loadMs = load;
+            if (r == 0 || cloned < copyMs) copyMs = cloned;
+            if (r == 0 || teardown < teardownMs) teardownMs = teardown;
+        }
+        std::cout << "  " << m.label << ": завантаження " << loadMs << ", копія " << copyMs
+            << ", знищення " << teardownMs << "\n";
+    }
+    std::remove(path.c_str());
+}
+
+// Ресурс-лічильник: скільки байтів пацієнти беруть із купи
+class CountingResource : public std::pmr::memory_resource {
+public:
+    std::size_t bytes = 0;
+
+private:
+    void* do_allocate(std::size_t size, std::size_t align) override {
+        bytes += size;
+        return std::pmr::new_delete_resource()->allocate(size, align);
+    }
+    void do_deallocate(void* p, std::size_t size, std::size_t align) override {
+        bytes -= size;
+        std::pmr::new_delete_resource()->deallocate(p, size, align);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+// Інтерновані поля: пам'ять на пацієнта і пошук за діагнозом (рядки проти номерів символів)
+void benchInterning(std::size_t count) {
+    const std::string path = "bench_patients.txt";
+    makeSyntheticClinic(count).saveToFile(path);
+    CountingResource counter;
+    Polyclinic clinic("Інтернування", "вул. Тестова, 1", 10, &counter);
+    clinic.loadFromFile(path, LoadMode::Mapped);
+    std::cout << "[interning] " << count << " пацієнтів\n";
+    std::cout << "  sizeof Patient/Child/Elder: " << sizeof(Patient) << "/" << sizeof(ChildPatient) << "/"
+        << sizeof(ElderPatient) << " байт; у купі " << static_cast<double>(counter.bytes) / static_cast<double>(count)
+        << " байт/пацієнт\n";
+
+    const auto n = static_cast<std::size_t>(clinic.getPatientsCount());
+    std::size_t byText = 0, bySymbol = 0;
+    const double textMs = benchBestMs(3, [&] {
+        byText = 0;
+        for (std::size_t i = 0; i < n; ++i) byText += clinic.getPatientPtr(i)->getDisease() == "Застуда" ? 1 : 0;
+    });
+    const double symbolMs = benchBestMs(3, [&] { bySymbol = clinic.countWithDisease("Застуда"); });
+    std::cout << "  пошук за діагнозом: рядки " << textMs * 1e6 / static_cast<double>(n) << " нс/запис, номери "
+        << symbolMs * 1e6 / static_cast<double>(n) << " нс/запис (" << byText << " = " << bySymbol << ")\n";
+    std::remove(path.c_str());
+}
+
+// Пропускна здатність пошуку роздільників для кожної доступної реалізації
+void benchDelimiterScan(std::size_t count) {
+    const std::string path = "bench_patients.txt";
+    makeSyntheticClinic(count).saveToFile(path);
+    const MappedFile file(path);
+    const double mb = static_cast<double>(file.size()) / (1024.0 * 1024.0);
+    std::cout << "[delimiters] " << mb << " МіБ\n";
+
+    std::vector<std::pair<const char*, ScanBlockFn>> impls{ { "scalar", scanBlockScalar } };
+#ifdef POLYCLINIC_X86
+    if (cpuHasSse2()) impls.emplace_back("SSE2  ", scanBlockSse2);
+    if (cpuHasAvx2()) impls.emplace_back("AVX2  ", scanBlockAvx2);
+#endif
+    for (const auto& [label, scan] : impls) {
+        std::uint64_t bounds = 0;
+        const double ms = benchBestMs(3, [&] {
+            bounds = 0;
+            for (std::size_t pos = 0; pos < file.size(); pos += kScanBlock)
+                bounds += popcount64(scanBlockAt(scan, file.begin(), pos, file.size()).fields);
+        });
+        std::cout << "  " << label << ": " << mb / (ms / 1000.0) << " МіБ/с (" << bounds << " меж)\n";
+    }
+    std::remove(path.c_str());
+}
+
+// Скан «пацієнти старші 65»: об'єкти через vtable проти колонкового сховища
+void benchColumnar(std::size_t count) {
+    const Polyclinic clinic = makeSyntheticClinic(count);
+    const ColumnarPatientStore columns(clinic);
+    std::cout << "[columnar] " << count << " пацієнтів, скан «вік > 65»\n";
+
+    std::size_t viaObjects = 0, viaColumns = 0;
+    const double objectsMs = benchBestMs(5, [&] {
+        viaObjects = 0;
+        for (int i = 0; i < clinic.getPatientsCount(); ++i)
+            viaObjects += clinic.getPatientPtr(static_cast<std::size_t>(i))->getAge() > 65 ? 1 : 0;
+    });
+    const double columnsMs = benchBestMs(5, [&] { viaColumns = columns.countOlderThan(65); });
+    std::cout << "  vector<unique_ptr<Patient>>: " << objectsMs * 1e6 / count << " нс/запис (" << viaObjects << ")\n";
+    std::cout << "  ColumnarPatientStore:        " << columnsMs * 1e6 / count << " нс/запис (" << viaColumns << ")\n";
+}
+
+// Рутинна аналітика: кількість за типом, середній вік Elder, неповнолітні з потребою дозволу —
+// віртуальні виклики по записах проти SIMD-сканів колонок клініки
+void benchColumnQueries(std::size_t count) {
+    const Polyclinic clinic = makeSyntheticClinic(count);
+    const auto n = static_cast<double>(clinic.getPatientsCount());
+    std::cout << "[column-queries] " << count << " пацієнтів: virtual / колонки, нс на запис\n";
+
+    std::array<std::size_t, 3> byTypeVirtual{}, byTypeColumns{};
+    const double typeVirtual = benchBestMs(3, [&] {
+        byTypeVirtual = {};
+        for (int i = 0; i < clinic.getPatientsCount(); ++i) ++byTypeVirtual[static_cast<std::size_t>(clinic.getPatientPtr(i)->type())];
+    });
+    const double typeColumns = benchBestMs(5, [&] { byTypeColumns = clinic.histogram(ColumnFilter{}); });
+
+    std::int64_t elderSum = 0, elderSumColumns = 0;
+    const double avgVirtual = benchBestMs(3, [&] {
+        elderSum = 0;
+        for (int i = 0; i < clinic.getPatientsCount(); ++i) {
+            const Patient* p = clinic.getPatientPtr(i);
+            if (p->type() == PatientType::Elder) elderSum += p->getAge();
+        }
+    });
+    const double avgColumns = benchBestMs(5, [&] { elderSumColumns = clinic.sumAges(ColumnFilter::of(PatientType::Elder)); });
+
+    std::size_t minors = 0, minorsColumns = 0;
+    const double minorsVirtualMs = benchBestMs(3, [&] {
+        minors = 0;
+        for (int i = 0; i < clinic.getPatientsCount(); ++i) {
+            const Patient* p = clinic.getPatientPtr(i);
+            if (p->type() == PatientType::Child) minors += static_cast<const ChildPatient*>(p)->needParentalPermission() ? 1 : 0;
+        }
+    });
+    const double minorsColumnsMs = benchBestMs(5, [&] { minorsColumns = clinic.count(ColumnFilter::of(PatientType::Child).ages(0, 17)); });
+
+    std::cout << "  кількість за типом:        " << typeVirtual * 1e6 / n << " / " << typeColumns * 1e6 / n
+        << " (" << byTypeVirtual[2] << " / " << byTypeColumns[2] << ")\n";
+    std::cout << "  сума віку Elder:           " << avgVirtual * 1e6 / n << " / " << avgColumns * 1e6 / n
+        << " (" << elderSum << " / " << elderSumColumns << ")\n";
+    std::cout << "  неповнолітні з дозволом:   " << minorsVirtualMs * 1e6 / n << " / " << minorsColumnsMs * 1e6 / n
+        << " (" << minors << " / " << minorsColumns << ")\n";
+}
+
+// Потік, що відкидає все (для вимірювання printInfo без виводу в консоль)
+class NullStreamBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+// Віртуальний шлях (vector<unique_ptr<Patient>>) проти variant-записів: збереження, вивід, фільтр
+void benchVariant(std::size_t count) {
+    const std::string path = "bench_patients.txt";
+    const Polyclinic clinic = makeSyntheticClinic(count);
+    const PatientRecordStore records(clinic);
+    const auto n = static_cast<std::size_t>(clinic.getPatientsCount());
+    std::cout << "[variant] " << count << " пацієнтів: virtual / std::visit, нс на запис\n";
+
+    const double saveVirtual = benchBestMs(3, [&] {
+        std::remove(path.c_str()); // без інкрементального збереження
+        clinic.saveToFile(path);
+    });
+    const double saveVariant = benchBestMs(3, [&] { records.saveToFile(path); });
+
+    NullStreamBuffer sink;
+    std::streambuf* console = std::cout.rdbuf(&sink);
+    const double printVirtual = benchBestMs(3, [&] { clinic.printAllPatients(); });
+    const double printVariant = benchBestMs(3, [&] { records.printAll(); });
+    std::cout.rdbuf(console);
+
+    std::size_t a = 0, b = 0;
+    const double filterVirtual = benchBestMs(3, [&] {
+        a = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            const Patient* p = clinic.getPatientPtr(i);
+            a += p->type() == PatientType::Elder && p->getAge() > 70 ? 1 : 0;
+        }
+    });
+    const double filterVariant = benchBestMs(3, [&] {
+        b = records.countIf([](const auto& p) {
+            return std::is_same_v<std::decay_t<decltype(p)>, ElderPatient> && p.getAge() > 70;
+        });
+    });
+    const auto perRecord = [n](double ms) { return ms * 1e6 / static_cast<double>(n); };
+    std::cout << "  saveToFile: " << perRecord(saveVirtual) << " / " << perRecord(saveVariant) << "\n";
+    std::cout << "  printInfo:  " << perRecord(printVirtual) << " / " << perRecord(printVariant) << "\n";
+    std::cout << "  фільтр (Elder, вік > 70): " << perRecord(filterVirtual) << " / " << perRecord(filterVariant)
+        << " (" << a << " = " << b << ")\n";
+    std::remove(path.c_str());
+}
+
+std::uintmax_t fileSize(const std::string& path) {
+    std::ifstream probe(path, std::ios::binary | std::ios::ate);
+    return static_cast<std::uintmax_t>(probe.tellg());
+}
+
+void benchSnapshot(std::size_t count) {
+    const std::string textPath = "bench_patients.txt", snapPath = "bench_patients.snap";
+    const Polyclinic source = makeSyntheticClinic(count);
+    Polyclinic clinic;
+
+    std::cout << "[saveSnapshot/loadSnapshot] " << count << " пацієнтів\n";
+    const double textSave = benchBestMs(3, [&] {
+        std::remove(textPath.c_str()); // інакше спрацює інкрементальне збереження
+        source.saveToFile(textPath);
+    });
+    const double textLoad = benchBestMs(3, [&] { clinic.loadFromFile(textPath, LoadMode::Mapped); });
+    const double snapSave = benchBestMs(3, [&] { source.saveSnapshot(snapPath, Durability::None); });
+    const double snapLoad = benchBestMs(3, [&] { clinic.loadSnapshot(snapPath); });
+    const auto textBytes = fileSize(textPath), snapBytes = fileSize(snapPath);
+    std::cout << "  текст (saveToFile): " << textBytes << " байт, збереження " << textSave
+        << " мс, завантаження " << textLoad << " мс\n";
+    std::cout << "  знімок:             " << snapBytes << " байт (" << 100.0 * snapBytes / textBytes
+        << "%), збереження " << snapSave << " мс, завантаження " << snapLoad << " мс\n";
+    std::remove(textPath.c_str());
+    std::remove(snapPath.c_str());
+}
+
+// Вартість довговічного запису однієї зміни: журнал з різним розміром групи проти
+// повного saveToFile після кожної зміни (на клініці з count пацієнтів)
+void benchJournal(std::size_t count) {
+    const std::string journalPath = "bench_journal.wal", textPath = "bench_patients.txt";
+    std::cout << "[journal] довговічний запис однієї зміни, клініка з " << count << " пацієнтів\n";
+    for (const std::size_t group : { std::size_t{ 1 }, std::size_t{ 64 } }) {
+        std::remove(journalPath.c_str());
+        Polyclinic clinic = makeSyntheticClinic(count);
+        clinic.openJournal(journalPath, group);
+        const int ops = group == 1 ? 200 : 20000;
+        const double ms = benchBestMs(1, [&] {
+            for (int i = 0; i < ops; ++i) clinic.addChild("Марта", 7, "Застуда", "Мама: +380501112233");
+            clinic.commitJournal();
+        });
+        std::cout << "  журнал, груповий коміт " << group << ": " << ms * 1000.0 / ops << " мкс/зміна\n";
+    }
+    Polyclinic clinic = makeSyntheticClinic(count);
+    const int ops = 5;
+    const double ms = benchBestMs(1, [&] {
+        for (int i = 0; i < ops; ++i) {
+            clinic.addChild("Марта", 7, "Застуда", "Мама: +380501112233");
+            clinic.saveToFile(textPath);
+        }
+    });
+    std::cout << "  saveToFile після кожної зміни: " << ms * 1000.0 / ops << " мкс/зміна (без fsync)\n";
+    std::remove(journalPath.c_str());
+    std::remove(textPath.c_str());
+}
+
+// Попередня реалізація toLine() (ланцюжок operator+ і std::to_string) — еталон «до»
+std::string legacyToLine(const Patient& p) {
+    std::string line = std::string(p.type() == PatientType::Child ? "Child" : p.type() == PatientType::Elder ? "Elder" : "Patient")
+        + "|" + std::string(p.getName()) + "|" + std::to_string(p.getAge()) + "|" + std::string(p.getDisease());
+    if (p.type() == PatientType::Child)
+        line = line + "|" + std::string(static_cast<const ChildPatient&>(p).getParentContact());
+    if (p.type() == PatientType::Elder) {
+        const auto& e = static_cast<const ElderPatient&>(p);
+        line = line + "|" + std::string(e.getAllergies()) + "|" + std::string(e.getContraindications());
+    }
+    return line;
+}
+
+// Пропускна здатність серіалізації: toLine()-конкатенація проти serializeTo у буфер
+void benchSerialize(std::size_t count) {
+    const std::string path = "bench_patients.txt";
+    const Polyclinic clinic = makeSyntheticClinic(count);
+    std::cout << "[serialize] " << count << " пацієнтів\n";
+
+    std::size_t bytes = 0;
+    const double before = benchBestMs(3, [&] {
+        std::ofstream ofs(path, std::ios::binary);
+        bytes = 0;
+        for (int i = 0; i < clinic.getPatientsCount(); ++i) {
+            const std::string line = legacyToLine(*clinic.getPatientPtr(static_cast<std::size_t>(i)));
+            ofs << line << '\n';
+            bytes += line.size() + 1;
+        }
+    });
+    const double after = benchBestMs(3, [&] {
+        std::remove(path.c_str()); // інакше спрацює інкрементальне збереження
+        clinic.saveToFile(path);
+    });
+    const double mb = static_cast<double>(bytes) / (1024.0 * 1024.0);
+    std::cout << "  до (toLine + ofstream <<): " << before << " мс, " << mb / (before / 1000.0) << " МіБ/с\n";
+    std::cout << "  після (serializeTo, блоки 1 МіБ): " << after << " мс, " << mb / (after / 1000.0) << " МіБ/с\n";
+    std::remove(path.c_str());
+}
+
+// Атомарне збереження: вартість запису і fsync окремо для обох рівнів довговічності
+void benchDurability(std::size_t count) {
+    const std::string path = "bench_patients.txt";
+    const Polyclinic clinic = makeSyntheticClinic(count);
+    std::cout << "[saveToFileAtomic] " << count << " пацієнтів\n";
+    for (const auto durability : { Durability::None, Durability::Fsync }) {
+        const SaveStats st = clinic.saveToFileAtomic(path, durability);
+        std::cout << "  " << (durability == Durability::None ? "None: " : "Fsync:") << " запис " << st.writeMs
+            << " мс, fsync " << st.fsyncMs << " мс, " << st.bytes / (1024 * 1024) << " МіБ\n";
+    }
+    std::remove(path.c_str());
+}
+
+// Періодичне автозбереження: повне збереження проти інкрементального після кількох змін
+void benchIncrementalSave(std::size_t count) {
+    const std::string path = "bench_patients.txt";
+    Polyclinic clinic = makeSyntheticClinic(count);
+    std::cout << "[saveToFile] автозбереження клініки з " << count << " пацієнтів\n";
+    const double full = benchBestMs(1, [&] { clinic.saveToFile(path); });
+    const double append = benchBestMs(3, [&] {
+        for (int i = 0; i < 10; ++i) clinic.addChild("Марта", 7, "Застуда", "Мама: +380501112233");
+        clinic.saveToFile(path);
+    });
+    const double tail = benchBestMs(3, [&] {
+        clinic.removePatientByIndex(static_cast<std::size_t>(clinic.getPatientsCount()) * 9 / 10);
+        clinic.saveToFile(path);
+    });
+    std::cout << "  повне: " << full << " мс; +10 прийомів: " << append
+        << " мс; видалення на 90% списку: " << tail << " мс\n";
+    std::remove(path.c_str());
+}
+
+int runBenchmarks(int argc, char* argv[]) {
+    const std::size_t count = argc > 2 ? static_cast<std::size_t>(std::stoull(argv[2])) : 1000000;
+    benchDelimiterScan(count);
+    benchLoadModes(count);
+    benchArena(count);
+    benchInterning(count);
+    benchDischarge(count);
+    benchCopyOnWrite(count);
+    benchMerge(count);
+    benchAdmission(count);
+    benchPurge(count);
+    benchInsertLatency(count * 4);
+    benchNameLookup(count);
+    benchNameSuggest(count);
+    benchFuzzyName(count);
+    benchNameIndexLoad(count);
+    benchAgeQueries(count);
+    benchTermQueries(count);
+    benchSnapshot(count);
+    benchJournal(count);
+    benchSerialize(count);
+    benchDurability(count);
+    benchIncrementalSave(count);
+    benchColumnar(count);
+    benchColumnQueries(count);
+    benchVariant(count);
+    return 0;
+}
+
 // ===========================
 // Тести (п.6–9)
 // ===========================
-int main() {
+int failedChecks = 0;
+
+// Перевірка для розділу (10): друкує результат і рахує невдалі
+void check(bool ok, const char* what) {
+    std::cout << "[Тест] " << what << " → " << (ok ? "OK" : "ПОМИЛКА") << "\n";
+    if (!ok) ++failedChecks;
+}
+
+// Ті самі пацієнти в тому самому порядку (порівнюються рядки формату saveToFile)
+bool samePatients(const Polyclinic& a, const Polyclinic& b) {
+    if (a.getPatientsCount() != b.getPatientsCount()) return false;
+    for (int i = 0; i < a.getPatientsCount(); ++i) {
+        if (a.getPatientPtr(static_cast<std::size_t>(i))->toLine() != b.getPatientPtr(static_cast<std::size_t>(i))->toLine())
+            return false;
+    }
+    return true;
+}
+
+// Індекси клініки (після завантаження вони будуються цілком) відповідають її записам
+bool indexesMatchRecords(const Polyclinic& clinic) {
+    for (std::size_t i = 0; i < static_cast<std::size_t>(clinic.getPatientsCount()); ++i) {
+        const Patient& p = *clinic.getPatientPtr(i);
+        const auto named = clinic.findByName(p.getName());
+        if (std::find(named.begin(), named.end(), clinic.getPatientId(i)) == named.end()) return false;
+        const Patient* same = clinic.getPatient(clinic.findByIdentity(p));
+        if (!same || *same != p) return false;
+    }
+    std::map<int, std::size_t> ages;
+    for (std::size_t i = 0; i < static_cast<std::size_t>(clinic.getPatientsCount()); ++i) ++ages[clinic.getPatientPtr(i)->getAge()];
+    std::size_t older = 0;
+    for (auto it = ages.rbegin(); it != ages.rend(); ++it) {
+        older += it->second;
+        if (clinic.countByAge(it->first) != it->second || clinic.countByAge(it->first, 1000) != older) return false;
+    }
+    const auto scanTerm = [&](std::string_view word) {
+        std::vector<PatientId> ids;
+        std::string term;
+        for (std::size_t i = 0; i < static_cast<std::size_t>(clinic.getPatientsCount()); ++i) {
+            bool found = false;
+            forEachTerm(clinic.getPatientPtr(i)->getDisease(), term, [&](std::string_view w) { found = found || w == word; });
+            if (found) ids.push_back(clinic.getPatientId(i));
+        }
+        return ids;
+    };
+    for (const std::string_view word : { "грип", "застуда", "гіпертонія", "17", "немає" }) {
+        auto indexed = clinic.findByTerm(TermField::Disease, word);
+        auto scanned = scanTerm(word);
+        const auto bySlot = [](PatientId a, PatientId b) { return a.slot < b.slot; };
+        std::sort(indexed.begin(), indexed.end(), bySlot);
+        std::sort(scanned.begin(), scanned.end(), bySlot);
+        if (indexed != scanned) return false;
+    }
+    for (const PatientType type : { PatientType::Patient, PatientType::Child, PatientType::Elder }) {
+        std::size_t scanned = 0;
+        std::int64_t ageSum = 0;
+        for (std::size_t i = 0; i < static_cast<std::size_t>(clinic.getPatientsCount()); ++i) {
+            if (clinic.getPatientPtr(i)->type() != type) continue;
+            ++scanned;
+            ageSum += clinic.getPatientPtr(i)->getAge();
+        }
+        if (clinic.count(ColumnFilter::of(type)) != scanned || clinic.sumAges(ColumnFilter::of(type)) != ageSum) return false;
+    }
+    return true;
+}
+
+// Невелика клініка для перевірок пошуку й аналітики
+Polyclinic makeCheckClinic() {
+    Polyclinic clinic("Перевірочна", "вул. Тестова, 1", 3);
+    clinic.addPatient(Patient{ "Олексій Ґонта", 40, "Гострий грип" });
+    clinic.addChild("Олена Коваль", 9, "Грип", "Мама: +380501112233");
+    clinic.addElder("Олег Шевченко", 78, "Гіпертонія", "Пеніцилін", "Кава");
+    clinic.addElder("Ірина Мельник", 66, "Грип, діабет", "Пеніцилін, аспірин", "Цукор");
+    clinic.addChild("Їжак Олійник", 15, "Травма", "Тато: +380631234567");
+    return clinic;
+}
+
+// Скалярний, SSE2 і AVX2 пошук роздільників (ті, що підтримує процесор) дає однакові
+// маски для data[0, size): кожен блок порівнюється з масками, побудованими побайтово
+bool scannersAgree(const char* data, std::size_t size) {
+    std::vector<ScanBlockFn> scanners{ scanBlockScalar };
+#ifdef POLYCLINIC_X86
+    if (cpuHasSse2()) scanners.push_back(scanBlockSse2);
+    if (cpuHasAvx2()) scanners.push_back(scanBlockAvx2);
+#endif
+    for (std::size_t pos = 0; pos < size; pos += kScanBlock) {
+        DelimiterMasks expected{ 0, 0 };
+        for (std::size_t i = pos; i < size && i < pos + kScanBlock; ++i) {
+            const std::uint64_t bit = std::uint64_t{ 1 } << (i - pos);
+            if (data[i] == '\n') expected.records |= bit;
+            if (data[i] == '\n' || data[i] == '|') expected.fields |= bit;
+        }
+        for (const ScanBlockFn scan : scanners) {
+            const DelimiterMasks got = scanBlockAt(scan, data, pos, size);
+            if (got.fields != expected.fields || got.records != expected.records) return false;
+        }
+    }
+    return true;
+}
+
+// Роздільник на кожному зсуві за модулем 32 (за будь-якого вирівнювання початку) і в
+// останньому байті буфера будь-якої довжини; довкола — байти, що відрізняються від '|' і '\n'
+// лише старшим бітом (перевірка знакового порівняння), і кирилиця
+bool delimiterScannersAgree() {
+    constexpr std::size_t kLength = 3 * kScanBlock;
+    std::vector<char> buffer(kLength + 32);
+    const auto fill = [&] {
+        const char filler[] = { 'a', static_cast<char>('|' | 0x80), static_cast<char>('\n' | 0x80), '\xD0', '\x9F', '\r', '{', '\0' };
+        for (std::size_t i = 0; i < buffer.size(); ++i) buffer[i] = filler[i % sizeof(filler)];
+    };
+    for (const char delimiter : { '|', '\n' }) {
+        for (std::size_t start = 0; start < 32; ++start) {
+            for (std::size_t at = 0; at < kLength; ++at) {
+                fill();
+                buffer[start + at] = delimiter;
+                if (!scannersAgree(buffer.data() + start, kLength)) return false;
+            }
+            for (std::size_t residue = 0; residue < 32; ++residue) {
+                fill();
+                for (std::size_t at = residue; at < kLength; at += 32) buffer[start + at] = delimiter;
+                if (!scannersAgree(buffer.data() + start, kLength)) return false;
+            }
+        }
+        for (std::size_t size = 1; size <= kLength; ++size) {
+            fill();
+            buffer[0] = delimiter;
+            buffer[size - 1] = delimiter;
+            if (!scannersAgree(buffer.data(), size)) return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string_view(argv[1]) == "--bench") return runBenchmarks(argc, argv);
+
     std::cout << "=== (пункти 1-6) ===\n";
     Polyclinic c1("Міська поліклініка №1", "вул. Головна, 10", 25);
 
@@ -347,6 +5816,17 @@ int main() {
         std::cout << "Помилка збереження: " << e.what() << "\n";
     }
 
+    std::cout << "\n=== (8) Завантаження з файлу (зворотне до saveToFile) ===\n";
+    try {
+        Polyclinic restored("Відновлена поліклініка", "вул. Головна, 10", 25);
+        restored.loadFromFile("patients.txt", LoadMode::Mapped);
+        restored.printInfo();
+        restored.printAllPatients();
+    }
+    catch (const FileLoadError& e) {
+        std::cout << "Помилка завантаження: " << e.what() << "\n";
+    }
+
     // ===========================
     // (9) Демонстрація обробки виключень
     // ===========================
@@ -371,7 +5851,18 @@ int main() {
         std::cout << "Спіймано EmptyClinicError: " << e.what() << "\n";
     }
 
-    // 3) FileSaveError: спроба зберегти в неіснуючу директорію
+    // 3) PatientIndexError: PatientId уже виписаного пацієнта
+    try {
+        std::cout << "[Тест] повторна виписка за тим самим PatientId\n";
+        const PatientId id = c1.addPatient(Patient{ "Тимчасовий", 30, "Застуда" });
+        c1.removePatient(id);
+        c1.removePatient(id);
+    }
+    catch (const PatientIndexError& e) {
+        std::cout << "Спіймано PatientIndexError: " << e.what() << "\n";
+    }
+
+    // 4) FileSaveError: спроба зберегти в неіснуючу директорію
     try {
         std::cout << "[Тест] збереження у 'nonexistent_dir/patients.txt'\n";
         c1.saveToFile("nonexistent_dir/patients.txt");
@@ -381,5 +5872,478 @@ int main() {
         std::cout << "Спіймано FileSaveError: " << e.what() << "\n";
     }
 
-    return 0;
+    // ===========================
+    // (10) Перевірки сховища, індексів і аналітики
+    // ===========================
+    std::cout << "\n=== (10) Перевірки ===\n";
+
+    check(delimiterScannersAgree(), "скалярний, SSE2 і AVX2 пошук роздільників дають однакові межі");
+
+    // Бінарний знімок: ті самі пацієнти після saveSnapshot → loadSnapshot
+    {
+        Polyclinic restored;
+        c1.saveSnapshot("check_patients.snap");
+        restored.loadSnapshot("check_patients.snap");
+        check(samePatients(c1, restored), "saveSnapshot → loadSnapshot повертає тих самих пацієнтів");
+        bool interned = true;
+        for (std::size_t i = 0; i < static_cast<std::size_t>(restored.getPatientsCount()); ++i) {
+            const Patient& p = *restored.getPatientPtr(i);
+            interned = interned && p.symbolPool().find(p.getDisease()) == p.diseaseSymbol();
+        }
+        check(interned && indexesMatchRecords(restored), "loadSnapshot: інтерновані поля й індекси");
+
+        // Знімок версії 1: ім'я і контакт батьків теж кодовані словником
+        {
+            AtomicFileWriter out("check_patients.snap", Durability::None);
+            writePod(out, kSnapshotMagic);
+            writePod(out, std::uint32_t{ 1 });
+            writePod(out, std::uint64_t{ 2 });
+            writePod(out, kSnapshotRequiredColumns);
+            writePod(out, std::uint32_t{ 0 });
+            const std::uint8_t types[] = { static_cast<std::uint8_t>(PatientType::Child), static_cast<std::uint8_t>(PatientType::Elder) };
+            const std::int32_t ages[] = { 7, 70 };
+            writeColumnHeader(out, SnapshotColumn::Type, 1, 2);
+            out.write(reinterpret_cast<const char*>(types), sizeof(types));
+            writeColumnHeader(out, SnapshotColumn::Age, 4, sizeof(ages));
+            out.write(reinterpret_cast<const char*>(ages), sizeof(ages));
+            const auto column = [&](SnapshotColumn id, std::string_view first, std::string_view second) {
+                DictionaryColumnWriter writer(2);
+                writer.push(first);
+                writer.push(second);
+                writer.writeTo(out, id);
+            };
+            column(SnapshotColumn::Name, "Марко Вовк", "Ганна Вовк");
+            column(SnapshotColumn::Disease, "Кір", "Гіпертонія");
+            column(SnapshotColumn::ParentContact, "Тато: +380671112233", "");
+            column(SnapshotColumn::Allergies, "", "Пилок");
+            column(SnapshotColumn::Contraindications, "", "Сіль");
+            out.commit();
+        }
+        Polyclinic old;
+        old.loadSnapshot("check_patients.snap");
+        check(old.getPatientsCount() == 2 && old.getPatientPtr(0)->toLine() == "Child|Марко Вовк|7|Кір|Тато: +380671112233"
+            && old.getPatientPtr(1)->toLine() == "Elder|Ганна Вовк|70|Гіпертонія|Пилок|Сіль", "loadSnapshot читає знімок версії 1");
+        std::remove("check_patients.snap");
+    }
+
+    // Журнал: нова клініка відтворює зміни; після checkpoint — знімок + лише новіші записи
+    {
+        std::remove("check_journal.wal");
+        Polyclinic live;
+        live.openJournal("check_journal.wal", 1);
+        live.addChild("Марта", 7, "Застуда", "Мама: +380501112233");
+        live.addElder("Петро", 72, "Гіпертонія", "Пеніцилін", "Кава");
+        live.addPatient(Patient{ "Олексій", 40, "Грип" });
+        live.removePatientByIndex(0);
+        live.commitJournal();
+        {
+            Polyclinic replayed;
+            replayed.openJournal("check_journal.wal");
+            check(samePatients(live, replayed), "openJournal відтворює додавання й видалення");
+        }
+        live.checkpoint("check_journal.snap");
+        live.addPatient(Patient{ "Ірина", 35, "Мігрень" });
+        live.commitJournal();
+        {
+            Polyclinic restored;
+            restored.loadSnapshot("check_journal.snap");
+            restored.openJournal("check_journal.wal");
+            check(samePatients(live, restored), "loadSnapshot + openJournal після checkpoint");
+        }
+    }
+    std::remove("check_journal.wal");
+    std::remove("check_journal.snap");
+
+    // Злиття тимчасової клініки в непорожню: PatientId обох частин дійсні, індекси спільні,
+    // журнал цілі відтворює влиті записи, журнал джерела — виписку всіх
+    {
+        std::remove("check_merge_region.wal");
+        std::remove("check_merge_district.wal");
+        const auto idsConsistent = [](const Polyclinic& clinic) {
+            std::vector<std::uint32_t> slots;
+            for (std::size_t i = 0; i < static_cast<std::size_t>(clinic.getPatientsCount()); ++i) {
+                const PatientId id = clinic.getPatientId(i);
+                if (clinic.getPatient(id) != clinic.getPatientPtr(i)) return false;
+                slots.push_back(id.slot);
+            }
+            std::sort(slots.begin(), slots.end());
+            return std::adjacent_find(slots.begin(), slots.end()) == slots.end();
+        };
+        Polyclinic region;
+        region.openJournal("check_merge_region.wal");
+        const PatientId marta = region.addChild("Марта", 7, "Застуда", "Мама: +380501112233");
+        const PatientId gone = region.addPatient(Patient{ "Олексій", 40, "Грип" });
+        const PatientId petro = region.addElder("Петро", 72, "Гіпертонія", "Пеніцилін", "Кава");
+        region.removePatient(gone);
+        Polyclinic district;
+        district.openJournal("check_merge_district.wal");
+        for (int i = 0; i < 300; ++i) district.addPatient(Patient{ "Районний " + std::to_string(i), 20 + i % 60, "Грип " + std::to_string(i % 7) });
+        district.addElder("Ганна", 81, "Гіпертонія, діабет", "Пилок", "Сіль");
+        district.removeIf([](const Patient& p) { return p.getAge() == 30; }); // вільні слоти в джерелі
+        std::vector<std::string> expected;
+        for (const Polyclinic* part : { &region, &district }) {
+            for (int i = 0; i < part->getPatientsCount(); ++i) expected.push_back(part->getPatientPtr(static_cast<std::size_t>(i))->toLine());
+        }
+        region += std::move(district);
+        const PatientId late = region.addPatient(Patient{ "Пізній", 55, "Діабет" }); // займає вільний слот
+        district.addPatient(Patient{ "Після злиття", 33, "Мігрень" });
+        expected.push_back(region.getPatientPtr(expected.size())->toLine());
+        bool merged = region.getPatientsCount() == static_cast<int>(expected.size());
+        for (std::size_t i = 0; merged && i < expected.size(); ++i) merged = region.getPatientPtr(i)->toLine() == expected[i];
+        const auto hanna = region.findByName("Ганна");
+        check(merged && region.getPatient(marta)->getName() == "Марта" && region.getPatient(petro)->getName() == "Петро"
+            && !region.getPatient(gone) && region.getPatient(late)->getName() == "Пізній" && idsConsistent(region),
+            "+= std::move у непорожню клініку: записи дописано, PatientId обох частин дійсні й різні");
+        check(hanna.size() == 1 && region.getPatient(hanna[0])->getAge() == 81 && region.findByTerm(TermField::Disease, "діабет").size() == 2
+            && region.suggestByName("Районний 299").size() == 1 && indexesMatchRecords(region),
+            "+= std::move: індекси злитої клініки відповідають записам");
+        region.commitJournal();
+        district.commitJournal();
+        Polyclinic replayedRegion;
+        replayedRegion.openJournal("check_merge_region.wal");
+        Polyclinic replayedDistrict;
+        replayedDistrict.openJournal("check_merge_district.wal");
+        check(samePatients(region, replayedRegion) && samePatients(district, replayedDistrict) && district.getPatientsCount() == 1,
+            "+= std::move: журнал цілі відтворює влиті записи, журнал джерела — виписку всіх");
+
+        // Записи займають цілі сторінки SlotMap — сторінки джерела приєднуються спільними
+        Polyclinic aligned;
+        for (int i = 0; i < 4096; ++i) aligned.addPatient(Patient{ "Сторінка " + std::to_string(i), i % 90, "Застуда " + std::to_string(i % 5) });
+        const Polyclinic before = aligned;
+        aligned += aligned;
+        aligned.addPatient(Patient{ "Після сторінок", 44, "Грип" });
+        check(aligned.getPatientsCount() == 2 * 4096 + 1 && before.getPatientsCount() == 4096 && idsConsistent(aligned)
+            && aligned.findByName("Сторінка 17").size() == 2 && indexesMatchRecords(aligned) && indexesMatchRecords(before),
+            "злиття цілими сторінками: записи й індекси, копія до злиття не змінилася");
+    }
+    std::remove("check_merge_region.wal");
+    std::remove("check_merge_district.wal");
+
+    // Позиція журналу в текстовому файлі читається в кожному режимі: openJournal після
+    // loadFromFile не відтворює вдруге зміни, які файл уже містить
+    {
+        std::remove("check_mark.wal");
+        Polyclinic live;
+        live.openJournal("check_mark.wal", 1);
+        live.addChild("Марта", 7, "Застуда", "Мама: +380501112233");
+        live.addPatient(Patient{ "Олексій", 40, "Грип" });
+        live.saveToFile("check_mark.txt");
+        live.addElder("Петро", 72, "Гіпертонія", "Пеніцилін", "Кава");
+        live.commitJournal();
+        bool allModes = true;
+        for (const LoadMode mode : { LoadMode::Stream, LoadMode::Mapped, LoadMode::Parallel }) {
+            Polyclinic restored;
+            restored.loadFromFile("check_mark.txt", mode);
+            restored.openJournal("check_mark.wal");
+            allModes = allModes && samePatients(live, restored);
+        }
+        check(allModes, "loadFromFile (Stream, Mapped, Parallel) + openJournal відтворює лише новіші зміни");
+    }
+    std::remove("check_mark.wal");
+    std::remove("check_mark.txt");
+
+    // Інкрементальне збереження: після змін файл такий самий, як повний запис у новий файл
+    {
+        const auto readAll = [](const std::string& path) {
+            std::ifstream in(path, std::ios::binary);
+            return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        };
+        Polyclinic clinic = c1;
+        clinic.saveToFile("check_incremental.txt");
+        clinic.addPatient(Patient{ "Богдан", 51, "Бронхіт" });
+        clinic.saveToFile("check_incremental.txt"); // лише дописування в кінець
+        clinic.removePatientByIndex(1);
+        clinic.saveToFile("check_incremental.txt"); // переписування з другого рядка
+        std::remove("check_full.txt");
+        clinic.saveToFile("check_full.txt");
+        check(readAll("check_incremental.txt") == readAll("check_full.txt"), "інкрементальний saveToFile збігається з повним");
+        Polyclinic restored;
+        restored.loadFromFile("check_incremental.txt");
+        check(samePatients(clinic, restored), "loadFromFile після інкрементальних збережень");
+    }
+    std::remove("check_incremental.txt");
+    std::remove("check_full.txt");
+
+    // Паралельне завантаження файлу з кількох частин (понад 1 МіБ на частину): рядки на межах
+    // частин не губляться і не дублюються, помилка в дальній частині має глобальний номер рядка
+    {
+        Polyclinic clinic;
+        for (int i = 0; i < 120000; ++i) {
+            const std::string pname = "Пацієнт " + std::to_string(i * 7919 % 100003);
+            if (i % 3 == 0) clinic.addChild(pname, i % 18, "Застуда", "Мама: +38050" + std::to_string(i));
+            else if (i % 3 == 1) clinic.addElder(pname, 60 + i % 40, "Гіпертонія", "Пеніцилін", "Кава");
+            else clinic.addPatient(Patient{ pname, 18 + i % 50, "Грип " + std::to_string(i % 97) });
+        }
+        clinic.saveToFile("check_parallel.txt");
+        Polyclinic streamed;
+        Polyclinic parallel;
+        streamed.loadFromFile("check_parallel.txt", LoadMode::Stream);
+        parallel.loadFromFile("check_parallel.txt", LoadMode::Parallel, 4);
+        check(samePatients(clinic, streamed) && samePatients(streamed, parallel), "LoadMode::Parallel (4 частини) дорівнює Stream");
+        check(indexesMatchRecords(parallel), "індекси, побудовані при завантаженні, відповідають записам");
+        Polyclinic grown = parallel;
+        for (int i = 0; i < 5000; ++i) grown.addPatient(Patient{ "Новий " + std::to_string(i), i % 200 - 20, "Грип грип " + std::to_string(i % 97) });
+        check(indexesMatchRecords(grown), "індекси після завантаження й нових прийомів");
+        grown.saveToFile("check_reload.txt");
+        Polyclinic reloaded;
+        reloaded.loadFromFile("check_reload.txt", LoadMode::Parallel, 4);
+        std::remove("check_reload.txt");
+        check(samePatients(grown, reloaded) && indexesMatchRecords(reloaded),
+            "індекси після повторного завантаження (вік поза 0..150, повтор слова в діагнозі)");
+
+        // Копія ділить сторінки записів та індексів з оригіналом; зміни оригіналу її не торкаються
+        Polyclinic frozen = grown;
+        std::vector<std::string> frozenLines;
+        for (int i = 0; i < frozen.getPatientsCount(); ++i) frozenLines.push_back(frozen.getPatientPtr(static_cast<std::size_t>(i))->toLine());
+        const auto frozenSuggested = frozen.suggestByName("Новий 12");
+        grown.addPatient(Patient{ "Пізній Пацієнт", 33, "Застуда" });
+        grown.removeIf([](const Patient& p) { return p.getAge() == 25; });
+        for (int i = 0; i < 50; ++i) grown.removePatientByIndex(static_cast<std::size_t>(i) * 2000);
+        bool frozenKept = frozen.getPatientsCount() == static_cast<int>(frozenLines.size());
+        for (int i = 0; frozenKept && i < frozen.getPatientsCount(); ++i)
+            frozenKept = frozen.getPatientPtr(static_cast<std::size_t>(i))->toLine() == frozenLines[static_cast<std::size_t>(i)];
+        check(frozenKept && frozen.findByName("Пізній Пацієнт").empty() && grown.findByName("Пізній Пацієнт").size() == 1
+            && frozen.countByAge(25) > 0 && grown.countByAge(25) == 0
+            && frozen.suggestByName("Новий 12") == frozenSuggested && frozen.suggestByName("Пізній").empty()
+            && frozen.fuzzyFind("Пізній Пацієнт", 1, 0).empty() && grown.fuzzyFind("Пізній Пацієнт", 1, 0).size() == 1,
+            "копія клініки не змінюється після прийомів і виписок в оригіналі");
+        check(indexesMatchRecords(frozen) && indexesMatchRecords(grown), "індекси копії й зміненого оригіналу відповідають записам");
+
+        std::string text;
+        {
+            std::ifstream in("check_parallel.txt", std::ios::binary);
+            text.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        constexpr std::size_t kBadLine = 100001; // у четвертій частині
+        std::size_t at = 0;
+        for (std::size_t line = 1; line < kBadLine; ++line) at = text.find('\n', at) + 1;
+        text.insert(at, "Patient|Зламаний|вік|Грип\n");
+        {
+            std::ofstream out("check_parallel.txt", std::ios::binary | std::ios::trunc);
+            out.write(text.data(), static_cast<std::streamsize>(text.size()));
+        }
+        std::string streamError, parallelError;
+        try { streamed.loadFromFile("check_parallel.txt", LoadMode::Stream); }
+        catch (const FileLoadError& e) { streamError = e.what(); }
+        try { parallel.loadFromFile("check_parallel.txt", LoadMode::Parallel, 4); }
+        catch (const FileLoadError& e) { parallelError = e.what(); }
+        check(!parallelError.empty() && parallelError == streamError
+            && parallelError.find("рядок " + std::to_string(kBadLine) + ":") != std::string::npos,
+            "LoadMode::Parallel: номер зламаного рядка в дальній частині глобальний");
+        check(samePatients(clinic, parallel), "невдале завантаження не змінює клініку");
+    }
+    std::remove("check_parallel.txt");
+
+    // Колонкове сховище: рядки 0..n-1 у порядку клініки
+    {
+        Polyclinic clinic;
+        clinic.addPatient(Patient{ "Олексій Ґонта", 40, "Гострий грип" });
+        clinic.addChild("Олена Коваль", 9, "Грип", "Мама: +380501112233");
+        clinic.addElder("Олег Шевченко", 78, "Гіпертонія", "Пеніцилін", "Кава");
+        clinic.addElder("Ірина Мельник", 66, "Грип, діабет", "Пеніцилін, аспірин", "Цукор");
+        clinic.addChild("Їжак Олійник", 15, "Травма", "Тато: +380631234567");
+        const ColumnarPatientStore store(clinic);
+        check(store.size() == 5 && store[3].getName() == "Ірина Мельник" && store[3].getAllergies() == "Пеніцилін, аспірин",
+            "ColumnarPatientStore: поля рядка");
+        check(store.countOlderThan(65) == 2 && store.averageAge(PatientType::Child) == 12.0,
+            "ColumnarPatientStore: countOlderThan(65) і averageAge(Child)");
+    }
+
+    // emplacePatient: той самий запис, що й через тимчасовий об'єкт
+    {
+        Polyclinic clinic;
+        const PatientId built = clinic.emplacePatient<Patient>("Олексій", 40, "Грип");
+        const PatientId copied = clinic.addPatient(Patient{ "Олексій", 40, "Грип" });
+        check(clinic.getPatient(built)->toLine() == clinic.getPatient(copied)->toLine(),
+            "emplacePatient<Patient> дорівнює addPatient(Patient{...})");
+        const PatientId child = clinic.emplacePatient<ChildPatient>("Марта", 7, "Застуда", "Мама: +380501112233");
+        check(clinic.getPatient(child)->type() == PatientType::Child && clinic.getPatient(child)->getName() == "Марта",
+            "emplacePatient<ChildPatient> будує дитячого пацієнта");
+    }
+
+    // Записи без віртуальної диспетчеризації: ті самі рядки й підтипи; сховища інтернують
+    // у власні пули (не в SymbolPool::global()) і не залежать від клініки, з якої побудовані
+    {
+        std::vector<std::string> lines;
+        std::unique_ptr<PatientRecordStore> records;
+        std::unique_ptr<ColumnarPatientStore> columns;
+        std::size_t globalBefore = 0;
+        bool copySharesPool = false;
+        {
+            const Polyclinic clinic = makeCheckClinic();
+            for (int i = 0; i < clinic.getPatientsCount(); ++i)
+                lines.emplace_back(clinic.getPatientPtr(static_cast<std::size_t>(i))->toLine());
+            globalBefore = SymbolPool::global().size();
+            records = std::make_unique<PatientRecordStore>(clinic);
+            columns = std::make_unique<ColumnarPatientStore>(clinic);
+            const auto& elder = static_cast<const ElderPatient&>(*clinic.getPatientPtr(2));
+            const ElderPatient copy(elder);
+            copySharesPool = &copy.symbolPool() == &elder.symbolPool() && copy.hasSameDisease(elder);
+        }
+        SerializeBuffer out;
+        records->serializeTo(out);
+        std::string expected;
+        for (const auto& line : lines) expected += line + "\n";
+        check(out.view() == expected, "PatientRecordStore: рядки клініки після її знищення");
+        const std::size_t elders = records->countIf([](const auto& p) {
+            return std::is_same_v<std::decay_t<decltype(p)>, ElderPatient>;
+        });
+        check(elders == 2 && records->materialize(2)->toLine() == lines[2] && (*columns)[3].materialize()->toLine() == lines[3],
+            "PatientRecordStore: підтипи записів; materialize обох сховищ");
+        check(copySharesPool && SymbolPool::global().size() == globalBefore,
+            "копія пацієнта ділить пул оригіналу; сховища не ростять SymbolPool::global()");
+    }
+
+    // Пам'ять пацієнтів: усі об'єкти й рядки — з ресурсу клініки, і вся вона повертається
+    {
+        CountingResource counting;
+        {
+            Polyclinic clinic("Пам'ять", "вул. Тестова, 2", 1, &counting);
+            clinic.addChild("Марта Ковальчук-Шевченко", 7, "Застуда", "Мама: +380501112233, тато: +380631234567");
+            clinic.addElder("Петро Іваненко", 72, "Серцеве захворювання", "Пеніцилін", "Інтенсивні навантаження");
+            clinic.addPatient(Patient{ "Олексій Довгоруков-Мельниченко", 40, "Грип" });
+            bool ownResource = true;
+            for (int i = 0; i < clinic.getPatientsCount(); ++i)
+                ownResource = ownResource && clinic.getPatientPtr(static_cast<std::size_t>(i))->memoryResource() == &counting;
+            check(ownResource && counting.bytes > 0, "пацієнти й рядки розміщені в ресурсі клініки");
+        }
+        check(counting.bytes == 0, "знищена клініка повертає ресурсу всю пам'ять");
+
+        Polyclinic arena("Арена", "вул. Тестова, 3", 1, PatientMemory::Arena);
+        arena.addChild("Марта", 7, "Застуда", "Мама: +380501112233");
+        Polyclinic copy = arena;
+        copy.addPatient(Patient{ "Олексій", 40, "Грип" });
+        check(arena.getPatientsCount() == 1 && copy.getPatientsCount() == 2
+            && arena.getPatientPtr(0)->memoryResource() != std::pmr::get_default_resource()
+            && copy.getPatientPtr(1)->memoryResource() != arena.getPatientPtr(0)->memoryResource(),
+            "PatientMemory::Arena: записи в арені; змінена копія пише у власну арену");
+    }
+
+    // Інтернування: однакові діагнози — один номер у пулі клініки; countWithDisease рахує й
+    // записи, влиті з інших клінік (у їхніх пулах)
+    {
+        Polyclinic clinic = makeCheckClinic();
+        const PatientId a = clinic.emplacePatient<Patient>("Андрій", 30, "Грип");
+        const PatientId b = clinic.emplacePatient<Patient>("Богдан", 31, "Грип");
+        check(clinic.getPatient(a)->diseaseSymbol() == clinic.getPatient(b)->diseaseSymbol()
+            && &clinic.getPatient(a)->symbolPool() == &clinic.getPatient(b)->symbolPool(),
+            "однаковий діагноз — той самий номер символу");
+        Polyclinic other;
+        other.emplacePatient<Patient>("Василь", 50, "Грип");
+        other.addElder("Галина", 70, "Діабет", "Немає", "Цукор");
+        clinic += other;
+        check(clinic.countWithDisease("Грип") == 4 && clinic.countWithDisease("Діабет") == 1
+            && clinic.countWithDisease("Невідомий діагноз") == 0, "countWithDisease після злиття клінік з різними пулами");
+    }
+
+    // removeIf: один прохід, порядок решти й їхні PatientId зберігаються
+    {
+        Polyclinic clinic;
+        std::vector<PatientId> ids;
+        for (int age = 0; age < 20; ++age) ids.push_back(clinic.emplacePatient<Patient>("Пацієнт " + std::to_string(age), age, "Грип"));
+        const std::size_t removed = clinic.removeIf([](const Patient& p) { return p.getAge() % 3 == 0; });
+        bool ordered = clinic.getPatientsCount() == 13;
+        for (int i = 1; ordered && i < clinic.getPatientsCount(); ++i)
+            ordered = clinic.getPatientPtr(static_cast<std::size_t>(i - 1))->getAge() < clinic.getPatientPtr(static_cast<std::size_t>(i))->getAge();
+        bool handles = true;
+        for (int age = 0; age < 20; ++age)
+            handles = handles && (clinic.getPatient(ids[static_cast<std::size_t>(age)]) == nullptr) == (age % 3 == 0);
+        check(removed == 7 && ordered, "removeIf видаляє 7 із 20 і зберігає порядок");
+        check(handles, "після removeIf дійсні лише PatientId тих, хто лишився");
+    }
+
+    // Індекс віку: межі діапазону і вік поза 0..150 (рахується за точним віком)
+    {
+        Polyclinic clinic;
+        for (const int age : { -5, -5, -1, 0, 17, 18, 150, 151, 200 })
+            clinic.emplacePatient<Patient>("Вік " + std::to_string(age), age, "Огляд");
+        check(clinic.countByAge(-5) == 2 && clinic.countByAge(-1) == 1 && clinic.countByAge(-7) == 0
+            && clinic.countByAge(151) == 1 && clinic.countByAge(152) == 0, "countByAge для віку поза 0..150");
+        check(clinic.countByAge(0) == 1 && clinic.countByAge(150) == 1 && clinic.countByAge(0, 17) == 2
+            && clinic.countByAge(17, 18) == 2 && clinic.countByAge(-5, 0) == 4 && clinic.countByAge(150, 300) == 3
+            && clinic.countByAge(18, 17) == 0, "countByAge(lo, hi): межі включно");
+        std::vector<int> visited;
+        clinic.rangeByAge(-3, 160, [&](PatientId, const Patient& p) { visited.push_back(p.getAge()); });
+        check(visited == std::vector<int>{ -1, 0, 17, 18, 150, 151 }, "rangeByAge(-3, 160) за зростанням віку");
+        clinic.removePatientByIndex(0);
+        check(clinic.countByAge(-5) == 1 && clinic.countByAge(-5, -1) == 2, "countByAge після виписки пацієнта з віком -5");
+    }
+
+    const Polyclinic sample = makeCheckClinic();
+    const auto namesOf = [&](const std::vector<PatientId>& ids) {
+        std::vector<std::string> names;
+        for (const PatientId id : ids) names.emplace_back(sample.getPatient(id)->getName());
+        return names;
+    };
+
+    // Інвертований індекс: слова без урахування регістру, AND і OR кількох умов
+    check(sample.findByTerm(TermField::Disease, "ГРИП").size() == 3, "findByTerm: «ГРИП» у діагнозі трьох пацієнтів");
+    check(namesOf(sample.findAll({ { TermField::Disease, "грип" }, { TermField::Allergies, "пеніцилін" } }))
+        == std::vector<std::string>{ "Ірина Мельник" }, "findAll: грип І алергія на пеніцилін");
+    check(sample.findAny({ { TermField::Disease, "травма" }, { TermField::Contraindications, "кава" } }).size() == 2,
+        "findAny: травма АБО протипоказана кава");
+
+    // Підказки за початком імені: за алфавітом, без регістру, ї/і та ґ/г рівнозначні
+    check(namesOf(sample.suggestByName("оле")) == std::vector<std::string>{ "Олег Шевченко", "Олексій Ґонта", "Олена Коваль" },
+        "suggestByName(\"оле\") за алфавітом");
+    check(namesOf(sample.suggestByName("ІЖАК о")) == std::vector<std::string>{ "Їжак Олійник" }, "suggestByName(\"ІЖАК о\")");
+    check(sample.suggestByName("ол", 2).size() == 2, "suggestByName обмежується maxResults");
+    {
+        // Після першого запиту нові імена йдуть у дельту й зливаються з блоками; копія бачить старий індекс
+        Polyclinic clinic = makeCheckClinic();
+        check(namesOf(clinic.suggestByName("оле")).size() == 3, "suggestByName будує індекс при першому запиті");
+        const Polyclinic before = clinic;
+        std::vector<PatientId> ids;
+        for (int i = 600; i >= 1; --i) {
+            char name[16];
+            std::snprintf(name, sizeof(name), "Тест %04d", i);
+            ids.push_back(clinic.addPatient(Patient{ name, 30, "Грип" }));
+        }
+        for (std::size_t i = 0; i < ids.size(); i += 3) clinic.removePatient(ids[i]);
+        std::vector<std::string> expected, actual;
+        for (int i = 100; i <= 199; ++i) {
+            if ((600 - i) % 3 == 0) continue; // виписані
+            char name[16];
+            std::snprintf(name, sizeof(name), "Тест %04d", i);
+            expected.emplace_back(name);
+        }
+        for (const PatientId id : clinic.suggestByName("тест 01", 1000)) actual.emplace_back(clinic.getPatient(id)->getName());
+        check(actual == expected && clinic.suggestByName("тест", 1000).size() == 400,
+            "suggestByName після 600 прийомів і 200 виписок");
+        check(before.suggestByName("тест").empty() && before.suggestByName("оле").size() == 3,
+            "suggestByName: копія до прийомів не бачить нових імен");
+    }
+
+    // Пошук з опечатками: найближчі імена першими, далекі не знаходяться
+    {
+        const auto typo = sample.fuzzyFind("Олекій Гонта", 3);
+        check(!typo.empty() && sample.getPatient(typo[0].id)->getName() == "Олексій Ґонта" && typo[0].distance == 1,
+            "fuzzyFind(\"Олекій Гонта\") → Олексій Ґонта, відстань 1");
+        const auto two = sample.fuzzyFind("Ирина Мелник", 3);
+        check(!two.empty() && sample.getPatient(two[0].id)->getName() == "Ірина Мельник" && two[0].distance == 2,
+            "fuzzyFind(\"Ирина Мелник\") → Ірина Мельник, відстань 2");
+        check(sample.fuzzyFind("Петро Петренко", 3).empty(), "fuzzyFind не знаходить далеких імен");
+
+        // Індекс побудовано першим запитом: далі прийоми й виписки оновлюють його, копія лишається старою
+        Polyclinic clinic = makeCheckClinic();
+        check(clinic.fuzzyFind("Олекій Гонта", 3).size() == 1, "fuzzyFind будує індекс при першому запиті");
+        const Polyclinic before = clinic;
+        const PatientId added = clinic.addPatient(Patient{ "Петро Петренко", 50, "Грип" });
+        const auto found = clinic.fuzzyFind("Петро Петренка", 3);
+        check(found.size() == 1 && found[0].id == added && before.fuzzyFind("Петро Петренка", 3).empty(),
+            "fuzzyFind бачить новий прийом, копія до прийому — ні");
+        clinic.removePatient(added);
+        check(clinic.fuzzyFind("Петро Петренка", 3).empty(), "fuzzyFind не знаходить виписаного");
+    }
+
+    // Аналітика за колонками віку й типу (вік: 40, дитина 9, літні 78 і 66, дитина 15)
+    check(sample.count(ColumnFilter{}) == 5 && sample.count(ColumnFilter::of(PatientType::Elder)) == 2,
+        "count: усього 5, літніх 2");
+    check(sample.sumAges(ColumnFilter::of(PatientType::Elder)) == 144, "sumAges літніх = 144");
+    check(sample.histogram(ColumnFilter{}.ages(10, 70)) == std::array<std::size_t, 3>{ 1, 1, 1 },
+        "histogram віку 10–70: по одному кожного типу");
+    check(namesOf(sample.filter(ColumnFilter::of(PatientType::Child).ages(0, 13))) == std::vector<std::string>{ "Олена Коваль" },
+        "filter: діти до 13 років");
+
+    return failedChecks == 0 ? 0 : 1;
 }
\ No newline at end of file